@@ -0,0 +1,55 @@
+#include "baseline.h"
+#include <cstdio>
+#include <cstring>
+
+void load_baseline(const char *path, bench_result *results, size_t count)
+{
+	auto *file = fopen(path, "r");
+	if (file == nullptr)
+		return;
+
+	char name[64];
+	unsigned long long value;
+
+	while (fscanf(file, "%63s %llu", name, &value) == 2) {
+		for (size_t i = 0; i < count; i++) {
+			if (strcmp(name, results[i].name) == 0)
+				results[i].baseline = value;
+		}
+	}
+
+	fclose(file);
+}
+
+bool save_baseline(const char *path, const bench_result *results, size_t count)
+{
+	auto *file = fopen(path, "w");
+	if (file == nullptr)
+		return false;
+
+	for (size_t i = 0; i < count; i++)
+		fprintf(file, "%s %llu\n", results[i].name, (unsigned long long)results[i].latest);
+
+	fclose(file);
+	return true;
+}
+
+void print_result_header()
+{
+	printf("%-16s %9s %9s %7s\n", "bench", "ns/op", "base", "change");
+}
+
+void print_result(const bench_result &result)
+{
+	const auto latest = (unsigned long long)result.latest;
+	const auto baseline = (unsigned long long)result.baseline;
+
+	if (baseline == 0) {
+		printf("%-16s %7llu.%llu\n", result.name, latest / 10, latest % 10);
+		return;
+	}
+
+	const auto change = ((double)latest - (double)baseline) * 100 / (double)baseline;
+	printf("%-16s %7llu.%llu %7llu.%llu %+6.1f%%\n", result.name, latest / 10, latest % 10,
+	       baseline / 10, baseline % 10, change);
+}
\ No newline at end of file
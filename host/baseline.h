@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <gctypes.h>
+
+// Benchmark timings in tenths of a nanosecond per operation. Baseline files are "name value"
+// lines, benches missing from the file have a baseline of 0.
+struct bench_result {
+	const char *name;
+	u64 latest;
+	u64 baseline;
+};
+
+void load_baseline(const char *path, bench_result *results, size_t count);
+
+bool save_baseline(const char *path, const bench_result *results, size_t count);
+
+void print_result_header();
+
+// Print latest next to the baseline and the relative change, if there is a baseline
+void print_result(const bench_result &result);
\ No newline at end of file
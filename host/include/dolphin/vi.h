@@ -0,0 +1,13 @@
+#pragma once
+
+#include <gctypes.h>
+
+namespace host {
+// Advanced by tests to simulate frames
+inline u32 retrace_count;
+} // namespace host
+
+inline u32 VIGetRetraceCount()
+{
+	return host::retrace_count;
+}
\ No newline at end of file
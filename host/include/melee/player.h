@@ -0,0 +1,53 @@
+#pragma once
+
+#include <gctypes.h>
+
+// Just enough of the game's player API for expressions to run on the host
+
+enum SlotType {
+	SlotType_Human = 0,
+	SlotType_CPU   = 1,
+	SlotType_Demo  = 2,
+	SlotType_None  = 3
+};
+
+struct Player {
+	u8 port;
+	u8 slot;
+	u32 action_state;
+};
+
+struct HSD_GObj {
+	void *data;
+
+	template<typename T>
+	T *get() const
+	{
+		return (T*)data;
+	}
+};
+
+namespace host {
+// Set up by tests in place of the match's player block
+inline SlotType slot_types[6] = {
+	SlotType_None, SlotType_None, SlotType_None, SlotType_None, SlotType_None, SlotType_None
+};
+inline Player players[6];
+inline HSD_GObj gobjs[6] = {
+	{ &players[0] }, { &players[1] }, { &players[2] }, { &players[3] }, { &players[4] }, { &players[5] }
+};
+// Counts accessor calls so tests can tell whether cached results were reused
+inline u32 player_block_reads;
+} // namespace host
+
+inline SlotType PlayerBlock_GetSlotType(s32 slot)
+{
+	host::player_block_reads++;
+	return host::slot_types[slot];
+}
+
+inline HSD_GObj *PlayerBlock_GetGObj(s32 slot)
+{
+	host::player_block_reads++;
+	return &host::gobjs[slot];
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "baseline.h"
+#include "dolphin/vi.h"
+#include "melee/player.h"
+#include "labscript/expression.h"
+#include "labscript/script.h"
+#include "labscript/serialize.h"
+#include "util/hash.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+using namespace labscript;
+
+#define CHECK(condition)                                                                           \
+	do {                                                                                       \
+		if (!(condition)) {                                                                \
+			printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);     \
+			failures++;                                                                \
+		}                                                                                  \
+	} while (false)
+
+static int failures;
+
+// Callers write the payload after the node
+static void write_node(writer *writer, hash_t hash, u8 flags, size_t payload_size = 0)
+{
+	writer->write(hash);
+	writer->write((u8)(flags | payload_size << node_flags::payload_shift));
+}
+
+// Literals, a player input read through the cache, and the same input at the top level
+static size_t write_test_script(void *buffer, size_t size, u16 node_count = 5)
+{
+	auto writer = labscript::writer(buffer, size);
+	const s32 int_value = 1234;
+	const f32 float_value = 0.5f;
+
+	writer.write(script_header {
+		.magic      = SCRIPT_MAGIC,
+		.version    = SCRIPT_VERSION,
+		.node_count = node_count
+	});
+
+	write_node(&writer, hash<"s32_literal">(), node_flags::has_next, sizeof(int_value));
+	writer.write(int_value);
+	write_node(&writer, hash<"f32_literal">(), node_flags::has_next, sizeof(float_value));
+	writer.write(float_value);
+	write_node(&writer, hash<"player_action_state">(), node_flags::has_input | node_flags::has_next);
+	write_node(&writer, hash<"human_player">(), 0);
+	write_node(&writer, hash<"human_player">(), 0);
+
+	return writer.overflowed() ? 0 : writer.written();
+}
+
+static const expression *get_node(const script &script, size_t index)
+{
+	const auto *expr = script.get_root();
+
+	for (size_t i = 0; i < index && expr != nullptr; i++)
+		expr = expr->next;
+
+	return expr;
+}
+
+static void test_round_trip()
+{
+	u8 encoded[256];
+	u8 reencoded[256];
+	const auto size = write_test_script(encoded, sizeof(encoded));
+	CHECK(size != 0);
+
+	script script;
+	CHECK(script.load(encoded, size) == result::ok);
+	CHECK(encode_script(script.get_root(), reencoded, sizeof(reencoded)) == size);
+	CHECK(memcmp(encoded, reencoded, size) == 0);
+
+	s32 int_value = 0;
+	f32 float_value = 0.f;
+	CHECK(get_node(script, 0)->evaluate(&int_value) == result::ok && int_value == 1234);
+	CHECK(get_node(script, 1)->evaluate(&float_value) == result::ok && float_value == 0.5f);
+}
+
+static void test_bad_scripts()
+{
+	u8 encoded[257];
+	const auto size = write_test_script(encoded, sizeof(encoded));
+
+	script script;
+
+	for (size_t truncated = 0; truncated < size; truncated++)
+		CHECK(script.load(encoded, truncated) != result::ok);
+
+	// Values are big-endian, with the header's magic first
+	CHECK(memcmp(encoded, "LSCR", 4) == 0);
+
+	// Trailing bytes
+	encoded[size] = 0;
+	CHECK(script.load(encoded, size + 1) == result::bad_format);
+
+	// Fewer nodes in the header than in the data
+	write_test_script(encoded, sizeof(encoded), 4);
+	CHECK(script.load(encoded, size) != result::ok);
+	write_test_script(encoded, sizeof(encoded));
+
+	// Corrupt the first node's hash
+	encoded[sizeof(script_header)] ^= 0xFF;
+	CHECK(script.load(encoded, size) == result::unknown_expression);
+	CHECK(!script.is_loaded());
+}
+
+// Inputs nested one level deeper than the decoder allows
+static void test_nesting()
+{
+	u8 encoded[512];
+	auto writer = labscript::writer(encoded, sizeof(encoded));
+	constexpr auto depth = MAX_DEPTH + 1;
+
+	writer.write(script_header {
+		.magic      = SCRIPT_MAGIC,
+		.version    = SCRIPT_VERSION,
+		.node_count = depth + 1
+	});
+
+	for (size_t i = 0; i < depth; i++)
+		write_node(&writer, hash<"player_action_state">(), node_flags::has_input);
+
+	write_node(&writer, hash<"human_player">(), 0);
+	CHECK(!writer.overflowed());
+
+	script script;
+	CHECK(script.load(encoded, writer.written()) == result::bad_format);
+}
+
+static void test_player_input()
+{
+	u8 encoded[256];
+	const auto size = write_test_script(encoded, sizeof(encoded));
+
+	script script;
+	CHECK(script.load(encoded, size) == result::ok);
+
+	const auto *action_state = get_node(script, 2);
+	s32 value = 0;
+
+	// No human players
+	host::retrace_count++;
+	CHECK(action_state->evaluate(&value) == result::ok && value == -1);
+
+	host::slot_types[1] = SlotType_Human;
+	host::players[1].action_state = 0x42;
+	host::retrace_count++;
+	CHECK(action_state->evaluate(&value) == result::ok && value == 0x42);
+
+	// The human_player input is cached for the rest of the frame
+	const auto reads = host::player_block_reads;
+	CHECK(action_state->evaluate(&value) == result::ok && value == 0x42);
+	CHECK(get_node(script, 3)->evaluate(nullptr) == result::ok);
+	CHECK(host::player_block_reads == reads);
+
+	host::retrace_count++;
+	CHECK(action_state->evaluate(&value) == result::ok);
+	CHECK(host::player_block_reads != reads);
+
+	host::slot_types[1] = SlotType_None;
+}
+
+// Time per node for each way of running the test script, in the baseline format util_bench uses
+static bool bench(size_t iterations, const char *baseline_path, bool save)
+{
+	u8 encoded[256];
+	const auto size = write_test_script(encoded, sizeof(encoded));
+
+	script script;
+	if (script.load(encoded, size) != result::ok)
+		return false;
+
+	host::slot_types[0] = SlotType_Human;
+
+	using run_t = labscript::result(*)(const expression *expr);
+	const run_t runs[] = {
+		[](const expression *expr) { return expr->execute(nullptr); },
+		[](const expression *expr) { return expr->evaluate(nullptr); },
+	};
+
+	bench_result results[] = {
+		{ .name = "execute" },
+		{ .name = "evaluate" },
+	};
+
+	load_baseline(baseline_path, results, std::size(results));
+	print_result_header();
+
+	for (size_t i = 0; i < std::size(runs); i++) {
+		size_t nodes = 0;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (size_t j = 0; j < iterations; j++) {
+			host::retrace_count++;
+
+			for (const auto *expr = script.get_root(); expr != nullptr; expr = expr->next, nodes++)
+				runs[i](expr);
+		}
+
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		const auto ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+		if (nodes == 0)
+			continue;
+
+		results[i].latest = ns * 10 / nodes;
+		print_result(results[i]);
+	}
+
+	host::slot_types[0] = SlotType_None;
+
+	if (save && !save_baseline(baseline_path, results, std::size(results))) {
+		printf("Failed to write %s.\n", baseline_path);
+		return false;
+	}
+
+	return true;
+}
+
+static void print_node(const expression *expr)
+{
+	u8 value[8] = {};
+	const auto error = expr->evaluate(value);
+
+	if (error != result::ok) {
+		printf("  %08X error %d\n", expr->get_hash(), (int)error);
+		return;
+	}
+
+	switch (expr->get_type()) {
+	case type::s32:    printf("  %08X s32 %d\n", expr->get_hash(), *(s32*)value);      break;
+	case type::f32:    printf("  %08X f32 %f\n", expr->get_hash(), *(f32*)value);      break;
+	case type::player: printf("  %08X player %p\n", expr->get_hash(), *(void**)value); break;
+	default:           printf("  %08X\n", expr->get_hash());                          break;
+	}
+}
+
+// Load a serialized script and evaluate its top level nodes
+static bool run_file(const char *path)
+{
+	auto *file = fopen(path, "rb");
+	if (file == nullptr) {
+		printf("%s: can't open\n", path);
+		return false;
+	}
+
+	static u8 data[0x10000];
+	const auto size = fread(data, 1, sizeof(data), file);
+	fclose(file);
+
+	script script;
+	if (const auto error = script.load(data, size); error != result::ok) {
+		printf("%s: load failed with error %d\n", path, (int)error);
+		return false;
+	}
+
+	printf("%s: %zu bytes, %zu bytes loaded\n", path, size, script.get_memory_size());
+
+	// Each file runs in a frame of its own
+	host::retrace_count++;
+
+	for (const auto *expr = script.get_root(); expr != nullptr; expr = expr->next)
+		print_node(expr);
+
+	return true;
+}
+
+// Usage: labscript [-b iterations] [-s] [-p baseline file] [script files...]
+// -b benchmarks against the baseline file if it exists, -s replaces it with this run's results.
+int main(int argc, char *argv[])
+{
+	size_t iterations = 0;
+	auto save = false;
+	const char *baseline_path = "labscript.baseline";
+
+	test_round_trip();
+	test_bad_scripts();
+	test_nesting();
+	test_player_input();
+
+	for (auto i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+			iterations = (size_t)strtoul(argv[++i], nullptr, 0);
+
+			if (iterations == 0) {
+				printf("Expected a positive iteration count.\n");
+				return EXIT_FAILURE;
+			}
+		} else if (strcmp(argv[i], "-s") == 0) {
+			save = true;
+		} else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			baseline_path = argv[++i];
+		} else if (!run_file(argv[i])) {
+			failures++;
+		}
+	}
+
+	if (iterations != 0 && !bench(iterations, baseline_path, save))
+		failures++;
+
+	printf("%s\n", failures == 0 ? "All checks passed." : "Some checks failed.");
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
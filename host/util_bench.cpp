@@ -0,0 +1,212 @@
+#include "baseline.h"
+#include "event/event.h"
+#include "util/bitwise.h"
+#include "util/hash.h"
+#include "util/ring_buffer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gctypes.h>
+#include <type_traits>
+
+// Keeps results from being optimized out
+static volatile u32 sink;
+
+static ring_buffer<u32, 64> pow2_ring;
+static ring_buffer<u32, 160> npot_ring;
+
+static event<void(u32 value)> events_1;
+static event<void(u32 value)> events_4;
+static event<void(u32 value)> events_16;
+
+static const char *const command_names[] = {
+	"latency_dump",
+	"savestate_save",
+	"action_stats_export",
+	"hookstats",
+};
+
+template<typename T>
+static void fill_ring(T *ring)
+{
+	for (size_t i = 0; i < ring->capacity() * 2; i++)
+		ring->add((u32)i);
+}
+
+static void add_handlers(event<void(u32 value)> *ev, size_t count)
+{
+	// Handlers can't be removed, so these live forever
+	for (size_t i = 0; i < count; i++)
+		new event_handler(ev, [](u32 value) { sink = sink + value; });
+}
+
+// Each benchmark returns the number of operations it performed
+struct util_bench {
+	const char *name;
+	size_t(*run)(size_t iterations);
+};
+
+static const util_bench benches[] = {
+	{ "ring_head", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			for (size_t offset = 0; offset < pow2_ring.stored(); offset++)
+				total += *pow2_ring.head(offset);
+		}
+
+		sink = total;
+		return iterations * pow2_ring.stored();
+	}},
+	{ "ring_index", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			for (size_t offset = 0; offset < pow2_ring.stored(); offset++)
+				total += pow2_ring[pow2_ring.head_index(offset)];
+		}
+
+		sink = total;
+		return iterations * pow2_ring.stored();
+	}},
+	{ "ring_index_npot", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			for (size_t offset = 0; offset < npot_ring.stored(); offset++)
+				total += npot_ring[npot_ring.head_index(offset)];
+		}
+
+		sink = total;
+		return iterations * npot_ring.stored();
+	}},
+	{ "ring_spans", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			for (const auto &span : pow2_ring.spans()) {
+				for (const auto value : span)
+					total += value;
+			}
+		}
+
+		sink = total;
+		return iterations * pow2_ring.stored();
+	}},
+	{ "fire_x1", [](size_t iterations) {
+		for (size_t i = 0; i < iterations; i++)
+			events_1.fire((u32)i);
+
+		return iterations;
+	}},
+	{ "fire_x4", [](size_t iterations) {
+		for (size_t i = 0; i < iterations; i++)
+			events_4.fire((u32)i);
+
+		return iterations;
+	}},
+	{ "fire_x16", [](size_t iterations) {
+		for (size_t i = 0; i < iterations; i++)
+			events_16.fire((u32)i);
+
+		return iterations;
+	}},
+	{ "bools_to_mask", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			const u32 bits = sink + (u32)i;
+			total += (u32)bools_to_mask(bits & 1, bits & 2, bits & 4, bits & 8,
+			                            bits & 16, bits & 32, bits & 64, bits & 128);
+		}
+
+		sink = total;
+		return iterations;
+	}},
+	{ "all_set", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++)
+			total += all_set(sink + (u32)i, 0x0F0Fu);
+
+		sink = total;
+		return iterations;
+	}},
+	{ "hash_runtime", [](size_t iterations) {
+		u32 total = 0;
+
+		for (size_t i = 0; i < iterations; i++) {
+			for (const auto *name : command_names)
+				total += hash(name);
+		}
+
+		sink = total;
+		return iterations * std::extent_v<decltype(command_names)>;
+	}},
+};
+
+constexpr auto bench_count = std::extent_v<decltype(benches)>;
+
+static bench_result results[bench_count];
+
+static void setup()
+{
+	fill_ring(&pow2_ring);
+	fill_ring(&npot_ring);
+	add_handlers(&events_1, 1);
+	add_handlers(&events_4, 4);
+	add_handlers(&events_16, 16);
+
+	for (size_t i = 0; i < bench_count; i++)
+		results[i].name = benches[i].name;
+}
+
+static void run_benches(size_t iterations)
+{
+	print_result_header();
+
+	for (size_t i = 0; i < bench_count; i++) {
+		const auto start = std::chrono::steady_clock::now();
+		const auto ops = benches[i].run(iterations);
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		const auto ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+		results[i].latest = ns * 10 / ops;
+		print_result(results[i]);
+	}
+}
+
+// Usage: util_bench [-n iterations] [-s] [baseline file]
+// Compares against the baseline file if it exists, -s replaces it with this run's results.
+int main(int argc, char *argv[])
+{
+	size_t iterations = 1000000;
+	auto save = false;
+	const char *path = "util_bench.baseline";
+
+	for (auto i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			iterations = (size_t)strtoul(argv[++i], nullptr, 0);
+		else if (strcmp(argv[i], "-s") == 0)
+			save = true;
+		else
+			path = argv[i];
+	}
+
+	if (iterations == 0) {
+		printf("Expected a positive iteration count.\n");
+		return EXIT_FAILURE;
+	}
+
+	setup();
+	load_baseline(path, results, bench_count);
+	run_benches(iterations);
+
+	if (save && !save_baseline(path, results, bench_count)) {
+		printf("Failed to write %s.\n", path);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -1,19 +1,17 @@
 #include "console/cvar.h"
 #include "console/console.h"
+#include <cstring>
 
 EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
 {
-	for (auto *cvar : console::cvar_base::iterate()) {
-		if (cmd_hash != cvar->name_hash)
-			continue;
+	auto *cvar = console::cvar_base::find(cmd_hash);
+	if (cvar == nullptr || strcmp(cvar->name, argv[0]) != 0)
+		return false;
 
-		if (argc >= 2)
-			cvar->set_value(argv[1]);
-		else
-			console::print("Expected a value.");
+	if (argc >= 2)
+		cvar->set_value(argv[1]);
+	else
+		console::print("Expected a value.");
 
-		return true;
-	}
-
-	return false;
+	return true;
 });
\ No newline at end of file
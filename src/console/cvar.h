@@ -3,6 +3,7 @@
 #include "console/console.h"
 #include "util/hash.h"
 #include "util/meta.h"
+#include <cassert>
 #include <limits>
 #include <type_traits>
 
@@ -41,10 +42,16 @@ public:
 		bool operator<=>(const iterator &other) const = default;
 	};
 
+	// Must be a power of two
+	static constexpr size_t TABLE_SIZE = 128;
+
 private:
 	inline static cvar_base *head;
 	cvar_base *next;
 
+	// Open addressed by name hash
+	inline static cvar_base *table[TABLE_SIZE];
+
 public:
 	const hash_t name_hash;
 	const char *const name;
@@ -58,6 +65,19 @@ protected:
 		// Link into list
 		next = head;
 		head = this;
+
+		for (size_t probe = 0; probe < TABLE_SIZE; probe++) {
+			auto *&slot = table[(name_hash + probe) % TABLE_SIZE];
+			if (slot == nullptr) {
+				slot = this;
+				return;
+			}
+		}
+
+		// Table is full, raise TABLE_SIZE
+#ifndef NDEBUG
+		__assert(__FILE__, __LINE__, "cvar table full");
+#endif
 	}
 
 public:
@@ -66,6 +86,18 @@ public:
 		return iterator(head);
 	}
 
+	// Look up the cvar with the given name hash, callers compare the name to rule out collisions
+	static cvar_base *find(hash_t hash)
+	{
+		for (size_t probe = 0; probe < TABLE_SIZE; probe++) {
+			auto *cvar = table[(hash + probe) % TABLE_SIZE];
+			if (cvar == nullptr || cvar->name_hash == hash)
+				return cvar;
+		}
+
+		return nullptr;
+	}
+
 	virtual bool set_value(const char *str) = 0;
 };
 
@@ -82,6 +114,17 @@ class cvar : public cvar_base {
 	const cvar_params params;
 	T value;
 
+	void print_range() const
+	{
+		if constexpr (std::is_integral_v<T>) {
+			console::printf("Expected value in range [%ld, %ld].\n",
+			                params.min, params.max);
+		} else if constexpr (std::is_floating_point_v<T>) {
+			console::printf("Expected value in range [%lf, %lf].\n",
+			                params.min, params.max);
+		}
+	}
+
 public:
 	template<size_t N>
 	cvar(const char (&name)[N], const cvar_params &params = {}) :
@@ -96,6 +139,25 @@ public:
 		return value;
 	}
 
+	// Set from code with the same checks as set_value
+	bool set(T new_value)
+	{
+		if (new_value < params.min || new_value > params.max) {
+			print_range();
+			return false;
+		}
+
+		if (params.validate != nullptr && !params.validate(new_value))
+			return false;
+
+		value = new_value;
+
+		if (params.set != nullptr)
+			params.set(value);
+
+		return true;
+	}
+
 	bool set_value(const char *str) override
 	{
 		char *end;
@@ -116,26 +178,13 @@ public:
 			return false;
 		}
 
+		// Check before narrowing so out of range values can't wrap into range
 		if (new_value < params.min || new_value > params.max) {
-			if constexpr (std::is_integral_v<T>) {
-				console::printf("Expected value in range [%ld, %ld].\n",
-				                params.min, params.max);
-			} else if constexpr (std::is_floating_point_v<T>) {
-				console::printf("Expected value in range [%lf, %lf].\n",
-				                params.min, params.max);
-			}
+			print_range();
 			return false;
 		}
 
-		if (params.validate != nullptr && !params.validate((T)new_value))
-			return false;
-
-		value = (T)new_value;
-
-		if (params.set != nullptr)
-			params.set(value);
-
-		return true;
+		return set((T)new_value);
 	}
 };
 
@@ -9,25 +9,36 @@
 #include "melee/characters/fox.h"
 #include "melee/scene.h"
 #include "console/console.h"
+#include "console/cvar.h"
 #include "match/events.h"
 #include "imgui/events.h"
 #include "input/poll.h"
 #include "player/events.h"
+#include "savestate/events.h"
+#include "savestate/savestate.h"
 #include "util/bitwise.h"
+#include "util/hash.h"
+#include "util/histogram.h"
 #include "util/hooks.h"
 #include "util/math.h"
 #include "util/ring_buffer.h"
+#include "util/time.h"
 #include "util/vector.h"
 #include "util/melee/character.h"
 #include "util/melee/ftcmd.h"
 #include "util/melee/pad.h"
+#include <algorithm>
 #include <bit>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
 #include <imgui.h>
 #include <ogc/machine/asm.h>
 #include <tuple>
 
-// How many recent inputs to remember
-constexpr size_t INPUT_BUFFER_SIZE = MAX_POLLS_PER_FRAME * PAD_QNUM;
+// How many recent input runs to remember, enough for every poll of each frame in the PAD queue.
+// Rounded up to a power of two so indices wrap with a mask.
+constexpr size_t INPUT_BUFFER_SIZE = std::bit_ceil((size_t)(MAX_POLLS_PER_FRAME * PAD_QNUM));
 // How many recent actions to remember
 constexpr size_t ACTION_BUFFER_SIZE = 64;
 // How many actions to display
@@ -36,10 +47,105 @@ constexpr size_t ACTION_HISTORY = 10;
 constexpr size_t PLINK_WINDOW = 3;
 // Frame window to consider actions to be intended one after another
 constexpr size_t ACT_OUT_WINDOW = 3;
-
+// How many action/base type pairs to keep statistics for
+constexpr size_t MAX_ACTION_STATS = 64;
+// Timing histogram buckets in hundredths of a frame, covering 6 frames
+constexpr size_t STATS_BUCKETS = 24;
+constexpr u32 STATS_BUCKET_SIZE = 25;
+
+// A run of identical polls received during the same frame. Only the first and last poll keep
+// their exact timestamps, the ones in between are approximate.
 struct saved_input {
 	u8 qwrite;
 	SIPadStatus status;
+	// Time of the first poll in the run
+	poll_timestamp timestamp;
+	// Time base of the last poll in the run
+	u64 last_time;
+	// Index of the first poll in the run
+	size_t first_poll;
+	// Number of polls in the run
+	size_t count;
+
+	size_t last_poll() const
+	{
+		return first_poll + count - 1;
+	}
+
+	poll_timestamp get_timestamp(size_t poll_index) const
+	{
+		if (count <= 1 || poll_index == first_poll)
+			return timestamp;
+
+		if (poll_index == last_poll())
+			return { .time = last_time, .retrace_count = timestamp.retrace_count };
+
+		// Interpolate between the run's measured ends. The SI polls at a fixed line interval, so
+		// this is only off by the interrupt latency of the polls in between.
+		const auto elapsed = last_time - timestamp.time;
+		const auto offset = (u64)(poll_index - first_poll);
+		return {
+			.time          = timestamp.time + elapsed * offset / (count - 1),
+			.retrace_count = timestamp.retrace_count
+		};
+	}
+};
+
+// Poll history indexed by poll, storing runs of identical polls as one entry
+class input_history {
+	ring_buffer<saved_input, INPUT_BUFFER_SIZE> runs;
+	size_t poll_count = 0;
+
+public:
+	const ring_buffer<saved_input, INPUT_BUFFER_SIZE> &get_runs() const
+	{
+		return runs;
+	}
+
+	void add(u8 qwrite, const SIPadStatus &status, const poll_timestamp &timestamp)
+	{
+		auto *run = runs.head();
+
+		if (run != nullptr && run->qwrite == qwrite &&
+		    run->timestamp.retrace_count == timestamp.retrace_count &&
+		    memcmp(&run->status, &status, sizeof(status)) == 0) {
+			run->last_time = timestamp.time;
+			run->count++;
+		} else {
+			runs.add({
+				.qwrite     = qwrite,
+				.status     = status,
+				.timestamp  = timestamp,
+				.last_time  = timestamp.time,
+				.first_poll = poll_count,
+				.count      = 1
+			});
+		}
+
+		poll_count++;
+	}
+
+	// Find the run containing a poll
+	const saved_input *get(size_t poll_index) const
+	{
+		// Runs are sorted by first poll, so binary search the stored range
+		size_t low = runs.tail_index();
+		size_t high = runs.head_index() + 1;
+
+		while (low < high) {
+			const auto middle = low + (high - low) / 2;
+			const auto *run = &runs[middle];
+
+			if (poll_index < run->first_poll)
+				high = middle;
+			else if (poll_index > run->last_poll())
+				low = middle + 1;
+			else
+				return run;
+		}
+
+		return nullptr;
+	}
 };
 
 struct processed_input {
@@ -115,6 +221,8 @@ struct action_entry {
 	const action_entry *base_action;
 	// Number of poll with input for this action
 	size_t poll_index;
+	// When the poll with input for this action was received
+	poll_timestamp timestamp;
 	// Input this action was detected with
 	processed_input input;
 	// Final input from the frame this action was performed on
@@ -133,6 +241,8 @@ struct action_entry {
 	bool confirmed;
 	// Whether the character actually performed the action
 	bool success;
+	// Whether this has been counted in the action statistics
+	bool stats_recorded;
 	// Bit returned by action_type::input_predicate
 	u8 input_type;
 	// Controller port
@@ -1466,16 +1576,129 @@ static const action_type *action_types[] = {
 };
 
 constexpr auto action_type_count = std::extent_v<decltype(action_types)>;
-static ring_buffer<saved_input, INPUT_BUFFER_SIZE> input_buffer[4];
+static input_history input_buffer[4];
 static ring_buffer<action_entry, ACTION_BUFFER_SIZE> action_buffer;
 static size_t last_action_poll[action_type_count];
 
-EVENT_HANDLER(events::input::poll, [](s32 chan, const SIPadStatus &status)
+static savestate::static_region input_buffer_region(input_buffer, sizeof(input_buffer));
+static savestate::static_region action_buffer_region(&action_buffer, sizeof(action_buffer));
+static savestate::static_region last_action_poll_region(last_action_poll,
+                                                        sizeof(last_action_poll));
+
+// Show the time between actions in microseconds instead of frames
+static console::cvar<int> action_timing_us("action_timing_us", {
+	.value = 0, .min = 0, .max = 1
+});
+
+static console::cvar<int> action_stats_panel("action_stats_panel", {
+	.value = 0, .min = 0, .max = 1
+});
+
+// Totals for one action type performed relative to one base action type
+struct action_stats {
+	u8 type_index;
+	// action_type_count if performed without a base action
+	u8 base_index;
+	u16 best_streak;
+	u16 streak;
+	u32 count;
+	u32 successes;
+	// Time since the base action, in hundredths of a frame
+	histogram<STATS_BUCKETS> timing = histogram<STATS_BUCKETS>(STATS_BUCKET_SIZE);
+};
+
+// Open addressed by type pair, kept across matches and savestates
+static action_stats stats_table[MAX_ACTION_STATS];
+static size_t stats_count;
+// Actions not counted because their type pair didn't fit in the table
+static u32 stats_dropped;
+
+static size_t get_type_index(const action_type *type)
 {
-	if (status.errstat == 0)
-		input_buffer[chan].add({ .qwrite = HSD_PadLibData.qwrite, .status = status });
+	return (size_t)(std::find(action_types, action_types + action_type_count, type) - action_types);
+}
+
+static action_stats *get_action_stats(size_t type_index, size_t base_index)
+{
+	const auto start = (type_index * (action_type_count + 1) + base_index) % MAX_ACTION_STATS;
+
+	for (size_t i = 0; i < MAX_ACTION_STATS; i++) {
+		auto *stats = &stats_table[(start + i) % MAX_ACTION_STATS];
+
+		if (stats->count == 0) {
+			// Unused slot, the pair hasn't been seen yet
+			stats->type_index = (u8)type_index;
+			stats->base_index = (u8)base_index;
+			stats_count++;
+			return stats;
+		}
+
+		if (stats->type_index == type_index && stats->base_index == base_index)
+			return stats;
+	}
+
+	return nullptr;
+}
+
+// Add a finished action to the statistics once its success is known
+static void record_action_stats(action_entry &action)
+{
+	// Actions added by state and confirmed after input both end up here
+	if (action.stats_recorded)
+		return;
+
+	action.stats_recorded = true;
+
+	const auto *type = action.type;
+
+	if (type->hidden || (type->must_succeed && !action.success))
+		return;
+
+	// Ignore base actions that got pushed out of the buffer
+	const auto *base = action.base_action;
+	if (base != nullptr && base->poll_index > action.poll_index)
+		base = nullptr;
+
+	const auto base_index = base != nullptr ? get_type_index(base->type) : action_type_count;
+	auto *stats = get_action_stats(get_type_index(type), base_index);
+
+	if (stats == nullptr) {
+		stats_dropped++;
+		return;
+	}
+
+	stats->count++;
+
+	if (action.success) {
+		stats->successes++;
+		stats->streak++;
+		stats->best_streak = std::max(stats->best_streak, stats->streak);
+	} else {
+		stats->streak = 0;
+	}
+
+	if (base != nullptr) {
+		const auto frame_delta = get_frame_delta(base->timestamp, action.timestamp);
+		if (frame_delta >= 0)
+			stats->timing.add((u32)(frame_delta * 100));
+	}
+}
+
+EVENT_HANDLER(events::input::deferred_poll, [](const poll_record &poll)
+{
+	if (poll.status.errstat == 0)
+		input_buffer[poll.chan].add(poll.qwrite, poll.status, poll.timestamp);
 });
 
+static poll_timestamp get_poll_timestamp(int port, size_t poll_index)
+{
+	if (const auto *input = input_buffer[port].get(poll_index); input != nullptr)
+		return input->get_timestamp(poll_index);
+
+	// Poll hasn't been received yet
+	return { .time = get_time(), .retrace_count = VIGetRetraceCount() };
+}
+
 struct action_detect_data {
 	u32 detected_inputs;
 	size_t bases_checked;
@@ -1483,10 +1706,15 @@ struct action_detect_data {
 };
 
 static void detect_action_for_input(const Player *player, const processed_input &input,
-                                    size_t poll_index, size_t type_index, action_detect_data *data)
+                                    const saved_input &run, size_t poll_index, u32 input_mask,
+                                    size_t type_index, action_detect_data *data)
 {
 	const auto &type = *action_types[type_index];
 
+	// Nothing new can be detected from an unchanged poll
+	if ((input_mask & ~data->detected_inputs) == 0 && type.base_input_predicate == nullptr)
+		return;
+
 	const action_entry *base = data->base;
 
 	const auto plink_delta = poll_index - last_action_poll[type_index];
@@ -1498,7 +1726,7 @@ static void detect_action_for_input(const Player *player, const processed_input
 		const auto max_offset = std::min(unchecked, action_buffer.stored());
 
 		for (size_t offset = 0; offset < max_offset; offset++) {
-			const auto *action = action_buffer.head(offset);
+			const auto *action = &action_buffer[action_buffer.head_index(offset)];
 
 			// Don't use previous inputs of a plinked action as a base
 			if (plinked && action->is_type(type))
@@ -1527,11 +1755,7 @@ static void detect_action_for_input(const Player *player, const processed_input
 			return;
 	}
 
-	// Don't detect the same inputs for the same action repeatedly in one frame
-	auto mask = 0u;
-
-	if (type.input_predicate != nullptr)
-		mask |= type.input_predicate(player, input);
+	auto mask = input_mask;
 
 	if (type.base_input_predicate != nullptr)
 		mask |= type.base_input_predicate(player, input, base);
@@ -1554,6 +1778,7 @@ static void detect_action_for_input(const Player *player, const processed_input
 			.type        = &type,
 			.base_action = base,
 			.poll_index  = poll_index,
+			.timestamp   = run.get_timestamp(poll_index),
 			.input       = input,
 			.active      = !type.must_succeed,
 			.input_type  = (u8)input_type,
@@ -1564,37 +1789,31 @@ static void detect_action_for_input(const Player *player, const processed_input
 
 static std::tuple<size_t, size_t> find_polls_for_frame(u8 port)
 {
-	const auto &buffer = input_buffer[port];
+	const auto &buffer = input_buffer[port].get_runs();
 
 	// Only use polls corresponding to this frame
 	const auto queue_index = decrement_mod((int)HSD_PadLibData.qread, PAD_QNUM);
 
-	// Head index must be saved because the interrupt can change it
-	const auto head_index = buffer.head_index();
-	const auto stored = std::min(head_index + 1, buffer.capacity());
-
 	// Find where the polls for this frame begin and end
-	const auto tail_index = head_index + 1 - stored;
-	const auto invalid_index = head_index + 1;
-	size_t start_index = tail_index;
-	size_t end_index = invalid_index;
+	auto found = false;
+	size_t start_index = 0;
+	size_t end_index = 0;
 
-	for (size_t offset = 0; offset < stored; offset++) {
-		const auto *input = buffer.get(head_index - offset);
+	for (size_t offset = 0; offset < buffer.stored(); offset++) {
+		const auto *run = &buffer[buffer.head_index(offset)];
 
-		if (input == nullptr)
-			continue;
+		if (run->qwrite == queue_index) {
+			if (!found)
+				end_index = run->last_poll();
 
-		if (end_index == invalid_index) {
-			if (input->qwrite == queue_index)
-				end_index = head_index - offset;
-		} else if (input->qwrite != queue_index) {
-			start_index = head_index - offset + 1;
+			start_index = run->first_poll;
+			found = true;
+		} else if (found) {
 			break;
 		}
 	}
 
-	if (end_index == invalid_index)
+	if (!found)
 		return std::make_tuple(1, 0);
 
 	return std::make_tuple(start_index, end_index);
@@ -1616,17 +1835,35 @@ EVENT_HANDLER(events::player::think::input::pre, [](Player *player)
 
 	auto [start_index, end_index] = find_polls_for_frame(player->port);
 
-	for (auto poll_index = start_index; poll_index <= end_index; poll_index++) {
+	for (auto poll_index = start_index; poll_index <= end_index;) {
 		const auto *input = input_buffer[player->port].get(poll_index);
 
-		if (input == nullptr)
+		if (input == nullptr) {
+			poll_index++;
 			continue;
+		}
+
+		const auto run = *input;
+		const auto processed = processed_input(player, run.status);
 
-		const auto processed = processed_input(player, input->status);
+		// Input predicates only depend on the poll, so evaluate them once per run
+		u32 input_masks[action_type_count];
 
 		for (auto type_index = 0zu; type_index < action_type_count; type_index++) {
-			detect_action_for_input(player, processed, poll_index, type_index,
-			                        &detect_data[type_index]);
+			const auto &type = *action_types[type_index];
+			input_masks[type_index] = type.input_predicate != nullptr
+			                        ? (u32)type.input_predicate(player, processed) : 0;
+		}
+
+		// State predicates depend on timing, so still check each poll in the run
+		const auto run_end = std::min(end_index, run.last_poll());
+
+		for (; poll_index <= run_end; poll_index++) {
+			for (auto type_index = 0zu; type_index < action_type_count; type_index++) {
+				detect_action_for_input(player, processed, run, poll_index,
+				                        input_masks[type_index], type_index,
+				                        &detect_data[type_index]);
+			}
 		}
 	}
 });
@@ -1639,45 +1876,60 @@ EVENT_HANDLER(events::player::think::input::post, [](Player *player, u32 old_sta
 	const auto port = player->port;
 	auto performed_action = false;
 
-	for (size_t offset = 0; offset < action_buffer.stored(); offset++) {
-		auto *action = action_buffer.tail(offset);
-		if (action->port != port)
-			continue;
+	for (const auto &span : action_buffer.spans()) {
+		for (auto &action : span) {
+			if (action.port != port)
+				continue;
 
-		const auto *type = action->type;
+			const auto *type = action.type;
 
-		// Store player input if the action was performed this frame
-		if (!action->final_input_set) {
-			action->final_input = player->input;
-			action->direction = player->direction;
-			action->final_input_set = true;
-		}
+			// Store player input if the action was performed this frame
+			if (!action.final_input_set) {
+				action.final_input = player->input;
+				action.direction = player->direction;
+				action.final_input_set = true;
 
-		if (!action->confirmed && type->success_predicate != nullptr) {
-			// Figure out which actions succeeded
-			if (!performed_action && type->success_predicate(player, new_state)) {
-				action->active = true;
-				action->success = true;
-				action->confirmed = true;
-				performed_action = true;
-			} else if (++action->success_timer >= type->success_window) {
-				action->active = !type->must_succeed;
-				action->confirmed = true;
+				if (type->success_predicate == nullptr)
+					record_action_stats(action);
 			}
-		}
 
-		if (action->active && type->end_predicate != nullptr) {
-			// Check if action can still be used as base
-			if (action->end_timer == 0) {
-				if (type->end_predicate(player))
-					action->end_timer = type->end_delay + 1;
-			} else if (--action->end_timer == 0) {
-				action->active = false;
+			if (!action.confirmed && type->success_predicate != nullptr) {
+				// Figure out which actions succeeded
+				if (!performed_action && type->success_predicate(player, new_state)) {
+					action.active = true;
+					action.success = true;
+					action.confirmed = true;
+					performed_action = true;
+					record_action_stats(action);
+				} else if (++action.success_timer >= type->success_window) {
+					action.active = !type->must_succeed;
+					action.confirmed = true;
+					record_action_stats(action);
+				}
+			}
+
+			if (action.active && type->end_predicate != nullptr) {
+				// Check if action can still be used as base
+				if (action.end_timer == 0) {
+					if (type->end_predicate(player))
+						action.end_timer = type->end_delay + 1;
+				} else if (--action.end_timer == 0) {
+					action.active = false;
+				}
 			}
 		}
 	}
 });
 
+EVENT_HANDLER(events::savestate::restore, []()
+{
+	// Restored actions were already counted, or will never finish in the timeline they came from
+	for (const auto &span : action_buffer.spans()) {
+		for (auto &action : span)
+			action.stats_recorded = true;
+	}
+});
+
 EVENT_HANDLER(events::player::as_change, [](Player *player, u32 old_state, u32 new_state)
 {
 	for (const auto *type : action_types) {
@@ -1694,12 +1946,14 @@ EVENT_HANDLER(events::player::as_change, [](Player *player, u32 old_state, u32 n
 		action_buffer.add({
 			.type        = type,
 			.poll_index  = poll_index,
+			.timestamp   = get_poll_timestamp(player->port, poll_index),
 			.active      = true,
 			.confirmed   = true,
 			.success     = true,
 			.port        = player->port
 		});
 
+		record_action_stats(*action_buffer.head());
 		return;
 	}
 });
@@ -1729,7 +1983,7 @@ EVENT_HANDLER(events::imgui::draw, []()
 	size_t displayed = 0;
 
 	for (size_t offset = 0; offset < max_count && displayed < ACTION_HISTORY; offset++) {
-		const auto *action = action_buffer.head(offset);
+		const auto *action = &action_buffer[action_buffer.head_index(offset)];
                 const auto *base_action = action->base_action;
 
 		if (action->type->hidden)
@@ -1755,13 +2009,15 @@ EVENT_HANDLER(events::imgui::draw, []()
 		ImGui::SameLine();
 
 		if (base_action != nullptr) {
-			const auto poll_delta = action->poll_index - base_action->poll_index;
-			const auto frame_delta = (float)poll_delta / Si.poll.y;
+			const auto frame_delta = get_frame_delta(base_action->timestamp,
+			                                         action->timestamp);
 
-			if (frame_delta < 100)
-				ImGui::Text("%5.2ff", frame_delta);
-			else
+			if (frame_delta >= 100)
 				ImGui::TextUnformatted("   ...");
+			else if (action_timing_us.get())
+				ImGui::Text("%5uus", ticks_to_us((u64)(frame_delta * FRAME_TICKS)));
+			else
+				ImGui::Text("%5.2ff", frame_delta);
 		} else {
 			ImGui::TextUnformatted("      ");
 		}
@@ -1799,6 +2055,198 @@ EVENT_HANDLER(events::imgui::draw, []()
 	ImGui::End();
 });
 
+static void plot_timing(const action_stats &stats)
+{
+	const auto getter = [](void *data, int index) {
+		return (float)static_cast<const action_stats*>(data)->timing.get((size_t)index);
+	};
+
+	ImGui::PushID(&stats);
+	ImGui::PlotHistogram("", getter, const_cast<action_stats*>(&stats), (int)STATS_BUCKETS, 0,
+	                     nullptr, 0.f, FLT_MAX, {96, 16});
+	ImGui::PopID();
+}
+
+EVENT_HANDLER(events::imgui::draw, []()
+{
+	if (!action_stats_panel.get())
+		return;
+
+	ImGui::SetNextWindowPos({320, 200}, ImGuiCond_FirstUseEver);
+	ImGui::Begin("Action stats", nullptr, ImGuiWindowFlags_NoNav
+	                                    | ImGuiWindowFlags_AlwaysAutoResize);
+
+	ImGui::BeginTable("Action stats", 6, ImGuiTableFlags_SizingFixedFit
+	                                   | ImGuiTableFlags_RowBg);
+	ImGui::TableSetupColumn("Action");
+	ImGui::TableSetupColumn("Count");
+	ImGui::TableSetupColumn("Success");
+	ImGui::TableSetupColumn("Streak");
+	ImGui::TableSetupColumn("Mean");
+	ImGui::TableSetupColumn("Timing");
+	ImGui::TableHeadersRow();
+
+	for (const auto &stats : stats_table) {
+		if (stats.count == 0)
+			continue;
+
+		const auto *type = action_types[stats.type_index];
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+
+		if (stats.base_index != action_type_count)
+			ImGui::Text("%s -> %s", action_types[stats.base_index]->name, type->name);
+		else
+			ImGui::TextUnformatted(type->name);
+
+		ImGui::TableNextColumn();
+		ImGui::Text("%u", stats.count);
+		ImGui::TableNextColumn();
+		ImGui::Text("%3u%%", stats.successes * 100 / stats.count);
+		ImGui::TableNextColumn();
+		ImGui::Text("%u/%u", stats.streak, stats.best_streak);
+		ImGui::TableNextColumn();
+
+		if (stats.timing.count() != 0) {
+			ImGui::Text("%5.2ff", (float)stats.timing.mean() / 100);
+			ImGui::TableNextColumn();
+			plot_timing(stats);
+		} else {
+			ImGui::TableNextColumn();
+		}
+	}
+
+	ImGui::EndTable();
+
+	if (stats_dropped != 0)
+		ImGui::Text("Table full, %u actions not counted", stats_dropped);
+
+	ImGui::End();
+});
+
+// Binary stats table:
+//
+//   header   u32 magic, u16 version, u16 type count, u16 entry count, u16 bucket size
+//   names    type count null terminated action type names
+//   entry    u8 type, u8 base, u16 best streak, u32 count, u32 successes, u16 buckets[]
+//
+// Bucket counts saturate at 0xFFFF. Written to the debug log as hex.
+constexpr u32 STATS_MAGIC   = 'ASTS';
+constexpr u16 STATS_VERSION = 1;
+
+struct stats_header {
+	u32 magic;
+	u16 version;
+	u16 type_count;
+	u16 entry_count;
+	u16 bucket_size;
+};
+
+struct stats_export_entry {
+	u8 type_index;
+	u8 base_index;
+	u16 best_streak;
+	u32 count;
+	u32 successes;
+	u16 buckets[STATS_BUCKETS];
+};
+
+// Buffers bytes into lines of hex for OSReport
+class hex_writer {
+	static constexpr size_t LINE_SIZE = 32;
+
+	u8 line[LINE_SIZE];
+	size_t line_size = 0;
+
+public:
+	size_t total_size = 0;
+
+	void write(const void *data, size_t size)
+	{
+		for (size_t i = 0; i < size; i++) {
+			line[line_size++] = ((const u8*)data)[i];
+
+			if (line_size == LINE_SIZE)
+				flush();
+		}
+
+		total_size += size;
+	}
+
+	void flush()
+	{
+		char text[LINE_SIZE * 2 + 1];
+
+		for (size_t i = 0; i < line_size; i++)
+			snprintf(&text[i * 2], 3, "%02X", line[i]);
+
+		text[line_size * 2] = '\0';
+
+		if (line_size != 0)
+			OSReport("%s\n", text);
+
+		line_size = 0;
+	}
+};
+
+static void export_action_stats()
+{
+	hex_writer writer;
+
+	const auto header = stats_header {
+		.magic       = STATS_MAGIC,
+		.version     = STATS_VERSION,
+		.type_count  = (u16)action_type_count,
+		.entry_count = (u16)stats_count,
+		.bucket_size = (u16)STATS_BUCKET_SIZE
+	};
+
+	writer.write(&header, sizeof(header));
+
+	for (const auto *type : action_types)
+		writer.write(type->name, strlen(type->name) + 1);
+
+	for (const auto &stats : stats_table) {
+		if (stats.count == 0)
+			continue;
+
+		auto entry = stats_export_entry {
+			.type_index  = stats.type_index,
+			.base_index  = stats.base_index,
+			.best_streak = stats.best_streak,
+			.count       = stats.count,
+			.successes   = stats.successes
+		};
+
+		for (size_t i = 0; i < STATS_BUCKETS; i++)
+			entry.buckets[i] = (u16)std::min(stats.timing.get(i), 0xFFFFu);
+
+		writer.write(&entry, sizeof(entry));
+	}
+
+	writer.flush();
+	console::printf("Wrote %u byte stats table to the debug log", (u32)writer.total_size);
+}
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	switch (cmd_hash) {
+	case hash<"action_stats_export">():
+		export_action_stats();
+		return true;
+	case hash<"action_stats_clear">():
+		for (auto &stats : stats_table)
+			stats = action_stats();
+
+		stats_count = 0;
+		stats_dropped = 0;
+		return true;
+	default:
+		return false;
+	}
+});
+
 EVENT_HANDLER(events::match::exit, []()
 {
 	action_buffer.clear();
@@ -0,0 +1,195 @@
+#include "dolphin/vi.h"
+#include "melee/constants.h"
+#include "console/cvar.h"
+#include "input/poll.h"
+#include "render/events.h"
+#include "render/overlay.h"
+#include "util/ring_buffer.h"
+#include "util/vector.h"
+#include "util/melee/pad.h"
+#include <algorithm>
+#include <bit>
+#include <gctypes.h>
+
+// How many frames of polls to show
+constexpr u32 TRAIL_FRAMES = 4;
+constexpr size_t TRAIL_LENGTH = MAX_POLLS_PER_FRAME * TRAIL_FRAMES;
+// Size and placement of the plots in screen space
+constexpr float PLOT_RADIUS = 32.f;
+constexpr float PLOT_SPACING = 80.f;
+constexpr float PORT_SPACING = 160.f;
+constexpr float PLOT_X = 50.f;
+constexpr float PLOT_Y = 420.f;
+
+// Vertices for both plots of a port, the gates and the 10 threshold lines
+constexpr size_t PLOT_VERTICES = overlay::CIRCLE_OUTLINE_VERTICES * 2 + overlay::LINE_VERTICES * 10;
+
+constexpr u32 GATE_COLOR   = 0xFFFFFF60;
+constexpr u32 TILT_COLOR   = 0x40FF4080;
+constexpr u32 SMASH_COLOR  = 0xFF404080;
+// Alternate colors for polls from even and odd frames
+constexpr u32 POLL_COLORS[] = { 0xFFE040FF, 0x40C0FFFF };
+
+// Screen position of a poll, computed once when it arrives
+struct trail_point {
+	vec2 position;
+	u32 color;
+	u32 retrace_count;
+	bool first_in_frame;
+};
+
+struct stick_trail {
+	ring_buffer<trail_point, TRAIL_LENGTH> stick;
+	ring_buffer<trail_point, TRAIL_LENGTH> cstick;
+	u32 retrace_count;
+	u32 frame_poll;
+};
+
+static stick_trail trails[4];
+
+// Bitmask of ports to show stick trajectories for
+static console::cvar<int> stick_trail_ports("stick_trail_ports", {
+	.value = 0, .min = 0, .max = 0b1111
+});
+
+static vec2 get_plot_center(s32 chan, int plot)
+{
+	return vec2(PLOT_X + (float)chan * PORT_SPACING + (float)plot * PLOT_SPACING, PLOT_Y);
+}
+
+static vec2 to_screen(const vec2 &center, const vec2 &stick)
+{
+	return vec2(center.x + stick.x * PLOT_RADIUS, center.y - stick.y * PLOT_RADIUS);
+}
+
+EVENT_HANDLER(events::input::deferred_poll, [](const poll_record &poll)
+{
+	if (poll.status.errstat != 0 || !(stick_trail_ports.get() & (1 << poll.chan)))
+		return;
+
+	auto &trail = trails[poll.chan];
+	const auto retrace_count = poll.timestamp.retrace_count;
+
+	if (retrace_count != trail.retrace_count) {
+		trail.retrace_count = retrace_count;
+		trail.frame_poll = 0;
+	}
+
+	// Fade later polls in a frame so the first one stands out
+	const auto first_in_frame = trail.frame_poll == 0;
+	const auto fade = std::min(trail.frame_poll++ * 0x10u, 0xA0u);
+	const auto color = POLL_COLORS[retrace_count % 2] - fade;
+
+	trail.stick.add({
+		.position       = to_screen(get_plot_center(poll.chan, 0),
+		                            convert_hw_coords(poll.status.stick)),
+		.color          = color,
+		.retrace_count  = retrace_count,
+		.first_in_frame = first_in_frame
+	});
+
+	trail.cstick.add({
+		.position       = to_screen(get_plot_center(poll.chan, 1),
+		                            convert_hw_coords(poll.status.cstick)),
+		.color          = color,
+		.retrace_count  = retrace_count,
+		.first_in_frame = first_in_frame
+	});
+});
+
+static void draw_threshold_x(const vec2 &center, float threshold, u32 color)
+{
+	const auto top = center.y - PLOT_RADIUS;
+	const auto bottom = center.y + PLOT_RADIUS;
+	const auto x = threshold * PLOT_RADIUS;
+	overlay::line(vec2(center.x + x, top), vec2(center.x + x, bottom), color);
+	overlay::line(vec2(center.x - x, top), vec2(center.x - x, bottom), color);
+}
+
+static void draw_threshold_y(const vec2 &center, float threshold, u32 color)
+{
+	const auto left = center.x - PLOT_RADIUS;
+	const auto right = center.x + PLOT_RADIUS;
+	const auto y = center.y - threshold * PLOT_RADIUS;
+	overlay::line(vec2(left, y), vec2(right, y), color);
+}
+
+// Gate and the thresholds check_*_region and friends compare against
+static void draw_plot(const vec2 &center, bool cstick)
+{
+	overlay::circle_outline(center, PLOT_RADIUS, GATE_COLOR);
+
+	if (cstick) {
+		draw_threshold_y(center, plco->usmash_threshold, SMASH_COLOR);
+		draw_threshold_y(center, plco->dsmash_threshold, SMASH_COLOR);
+		return;
+	}
+
+	draw_threshold_x(center, plco->ftilt_threshold, TILT_COLOR);
+	draw_threshold_y(center, plco->utilt_threshold, TILT_COLOR);
+	draw_threshold_y(center, plco->dtilt_threshold, TILT_COLOR);
+	draw_threshold_x(center, plco->x_smash_threshold, SMASH_COLOR);
+	draw_threshold_y(center, plco->y_smash_threshold, SMASH_COLOR);
+	draw_threshold_y(center, -plco->y_smash_threshold, SMASH_COLOR);
+}
+
+// Vertices drawn for a point, the line from the previous point and the frame marker
+static size_t get_point_vertices(const trail_point &point)
+{
+	return overlay::LINE_VERTICES + (point.first_in_frame ? overlay::RECT_VERTICES : 0);
+}
+
+// Draw as much of the trail as fits in max_vertices, dropping the oldest points first
+static void draw_trail(const ring_buffer<trail_point, TRAIL_LENGTH> &trail, size_t max_vertices)
+{
+	const auto oldest_retrace = VIGetRetraceCount() - TRAIL_FRAMES;
+	size_t count = 0;
+	size_t vertices = 0;
+
+	for (; count < trail.stored(); count++) {
+		const auto &point = *trail.head(count);
+		vertices += get_point_vertices(point);
+
+		if ((s32)(point.retrace_count - oldest_retrace) < 0 || vertices > max_vertices)
+			break;
+	}
+
+	const trail_point *last = nullptr;
+
+	for (auto offset = count; offset-- != 0;) {
+		const auto &point = *trail.head(offset);
+
+		if (last != nullptr)
+			overlay::line(last->position, point.position, point.color);
+
+		// Mark where each frame's polls start
+		if (point.first_in_frame)
+			overlay::rect(vec2(point.position.x - 1.f, point.position.y - 1.f),
+			              vec2(point.position.x + 1.f, point.position.y + 1.f),
+			              point.color);
+
+		last = &point;
+	}
+}
+
+EVENT_HANDLER(events::render::overlay, []()
+{
+	const auto ports = (u32)stick_trail_ports.get();
+	auto ports_left = std::popcount(ports);
+
+	for (auto chan = 0; chan < 4; chan++) {
+		if (!(ports & (1 << chan)))
+			continue;
+
+		// Split what's left between the remaining ports so each gets its plots and recent polls
+		const auto budget = overlay::get_free_vertices() / (size_t)ports_left--;
+		if (budget < PLOT_VERTICES)
+			continue;
+
+		const auto trail_budget = (budget - PLOT_VERTICES) / 2;
+		draw_plot(get_plot_center(chan, 0), false);
+		draw_plot(get_plot_center(chan, 1), true);
+		draw_trail(trails[chan].stick, trail_budget);
+		draw_trail(trails[chan].cstick, trail_budget);
+	}
+});
\ No newline at end of file
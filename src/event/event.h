@@ -1,6 +1,7 @@
 #pragma once
 
 #include "util/preprocessor.h"
+#include "util/spsc_queue.h"
 #include <type_traits>
 #include <utility>
 
@@ -54,4 +55,27 @@ struct event_handler<ret(args...)> {
 };
 
 template<typename callback_type>
-event_handler(event<callback_type>*, auto) -> event_handler<callback_type>;
\ No newline at end of file
+event_handler(event<callback_type>*, auto) -> event_handler<callback_type>;
+
+// Event whose fire() only queues a record, so it can be used from interrupts. Handlers run when
+// the owner calls drain().
+template<typename T, size_t N>
+struct deferred_event : event<void(const T &record)> {
+	spsc_queue<T, N> queue;
+	// Records lost because the queue was full
+	unsigned int dropped;
+
+	void fire(const T &record)
+	{
+		if (!queue.push(record))
+			dropped++;
+	}
+
+	void drain()
+	{
+		T record;
+
+		while (queue.pop(&record))
+			event<void(const T &record)>::fire(record);
+	}
+};
\ No newline at end of file
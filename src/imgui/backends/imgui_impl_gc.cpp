@@ -1,11 +1,13 @@
 // dear imgui: Platform Backend for Nintendo GameCube
 // This needs to be used along with the GX Renderer.
 
+#include "dolphin/os.h"
 #include "dolphin/serial.h"
 #include "hsd/pad.h"
 #include "imgui/events.h"
 #include "imgui/backends/imgui_impl_gc.h"
 #include "util/vector.h"
+#include <array>
 #include <imgui.h>
 
 struct ImGui_ImplGC_Pad {
@@ -18,6 +20,26 @@ struct ImGui_ImplGC_Pad {
 	f32 analog_r;
 };
 
+// How often to check for a keyboard being plugged in or removed
+constexpr auto KEYBOARD_TYPE_INTERVAL = 60;
+// Under/overrun, collision and no response bits of the SI status
+constexpr u32 SI_ERROR_MASK = 0x0F;
+
+// Keyboard transfer state, outside of the backend data since SI callbacks have no context
+struct ImGui_ImplGC_Keyboard {
+	// Cached SI_GetType result
+	u32 type;
+	// Frames until the type is checked again
+	int type_timer;
+	// The transfer in progress writes to the buffer that isn't published
+	SIKeyboardStatus buffers[2];
+	// Index of the most recently completed buffer, or -1 if there is none
+	volatile int published;
+	volatile bool busy;
+};
+
+static ImGui_ImplGC_Keyboard keyboards[4];
+
 // GC Data
 struct ImGui_ImplGC_Data {
 	ImGui_ImplGC_Pad last_pad[4];
@@ -65,23 +87,127 @@ void ImGui_ImplGC_Shutdown()
 	io.BackendPlatformUserData = NULL;
 }
 
-static void ImGui_ImplGC_CheckKey(const SIKeyboardStatus &kb, const SIKeyboardStatus &last_kb,
-                                  int si_key, auto ...imgui_keys)
+struct ImGui_ImplGC_KeyMapping {
+	ImGuiKey key;
+	// Modifier to update along with key, or ImGuiKey_None
+	ImGuiKey mod;
+};
+
+// Translation from SI key codes, some of these are mapped differently due to keyboard layout
+static constexpr auto ImGui_ImplGC_KeyMap = []() {
+	std::array<ImGui_ImplGC_KeyMapping, 256> map = {};
+
+	map[KEY_HOME]           = { ImGuiKey_Home };
+	map[KEY_END]            = { ImGuiKey_End };
+	map[KEY_PGUP]           = { ImGuiKey_PageUp };
+	map[KEY_PGDN]           = { ImGuiKey_PageDown };
+	map[KEY_SCROLLLOCK]     = { ImGuiKey_ScrollLock };
+	map[KEY_A]              = { ImGuiKey_A };
+	map[KEY_B]              = { ImGuiKey_B };
+	map[KEY_C]              = { ImGuiKey_C };
+	map[KEY_D]              = { ImGuiKey_D };
+	map[KEY_E]              = { ImGuiKey_E };
+	map[KEY_F]              = { ImGuiKey_F };
+	map[KEY_G]              = { ImGuiKey_G };
+	map[KEY_H]              = { ImGuiKey_H };
+	map[KEY_I]              = { ImGuiKey_I };
+	map[KEY_J]              = { ImGuiKey_J };
+	map[KEY_K]              = { ImGuiKey_K };
+	map[KEY_L]              = { ImGuiKey_L };
+	map[KEY_M]              = { ImGuiKey_M };
+	map[KEY_N]              = { ImGuiKey_N };
+	map[KEY_O]              = { ImGuiKey_O };
+	map[KEY_P]              = { ImGuiKey_P };
+	map[KEY_Q]              = { ImGuiKey_Q };
+	map[KEY_R]              = { ImGuiKey_R };
+	map[KEY_S]              = { ImGuiKey_S };
+	map[KEY_T]              = { ImGuiKey_T };
+	map[KEY_U]              = { ImGuiKey_U };
+	map[KEY_V]              = { ImGuiKey_V };
+	map[KEY_W]              = { ImGuiKey_W };
+	map[KEY_X]              = { ImGuiKey_X };
+	map[KEY_Y]              = { ImGuiKey_Y };
+	map[KEY_Z]              = { ImGuiKey_Z };
+	map[KEY_1]              = { ImGuiKey_1 };
+	map[KEY_2]              = { ImGuiKey_2 };
+	map[KEY_3]              = { ImGuiKey_3 };
+	map[KEY_4]              = { ImGuiKey_4 };
+	map[KEY_5]              = { ImGuiKey_5 };
+	map[KEY_6]              = { ImGuiKey_6 };
+	map[KEY_7]              = { ImGuiKey_7 };
+	map[KEY_8]              = { ImGuiKey_8 };
+	map[KEY_9]              = { ImGuiKey_9 };
+	map[KEY_0]              = { ImGuiKey_0 };
+	map[KEY_MINUS]          = { ImGuiKey_Minus };
+	map[KEY_PLUS]           = { ImGuiKey_GraveAccent };
+	map[KEY_PRINTSCR]       = { ImGuiKey_PrintScreen };
+	map[KEY_BRACE_OPEN]     = { ImGuiKey_Apostrophe };
+	map[KEY_BRACE_CLOSE]    = { ImGuiKey_LeftBracket };
+	map[KEY_COLON]          = { ImGuiKey_Equal };
+	map[KEY_HASH]           = { ImGuiKey_RightBracket };
+	map[KEY_COMMA]          = { ImGuiKey_Comma };
+	map[KEY_PERIOD]         = { ImGuiKey_Period };
+	map[KEY_QUESTIONMARK]   = { ImGuiKey_Slash };
+	map[KEY_INTERNATIONAL1] = { ImGuiKey_Backslash };
+	map[KEY_F1]             = { ImGuiKey_F1 };
+	map[KEY_F2]             = { ImGuiKey_F2 };
+	map[KEY_F3]             = { ImGuiKey_F3 };
+	map[KEY_F4]             = { ImGuiKey_F4 };
+	map[KEY_F5]             = { ImGuiKey_F5 };
+	map[KEY_F6]             = { ImGuiKey_F6 };
+	map[KEY_F7]             = { ImGuiKey_F7 };
+	map[KEY_F8]             = { ImGuiKey_F8 };
+	map[KEY_F9]             = { ImGuiKey_F9 };
+	map[KEY_F10]            = { ImGuiKey_F10 };
+	map[KEY_F11]            = { ImGuiKey_F11 };
+	map[KEY_F12]            = { ImGuiKey_F12 };
+	map[KEY_ESC]            = { ImGuiKey_Escape };
+	map[KEY_INSERT]         = { ImGuiKey_Insert };
+	map[KEY_DELETE]         = { ImGuiKey_Delete };
+	map[KEY_TILDE]          = { ImGuiKey_Semicolon };
+	map[KEY_BACKSPACE]      = { ImGuiKey_Backspace };
+	map[KEY_TAB]            = { ImGuiKey_Tab };
+	map[KEY_CAPSLOCK]       = { ImGuiKey_CapsLock };
+	map[KEY_LEFTSHIFT]      = { ImGuiKey_LeftShift, ImGuiKey_ModShift };
+	map[KEY_RIGHTSHIFT]     = { ImGuiKey_RightShift, ImGuiKey_ModShift };
+	map[KEY_LEFTCONTROL]    = { ImGuiKey_LeftCtrl, ImGuiKey_ModCtrl };
+	map[KEY_RIGHTALT]       = { ImGuiKey_RightAlt, ImGuiKey_ModAlt };
+	map[KEY_LEFTWINDOWS]    = { ImGuiKey_LeftSuper, ImGuiKey_ModSuper };
+	map[KEY_SPACE]          = { ImGuiKey_Space };
+	map[KEY_RIGHTWINDOWS]   = { ImGuiKey_RightSuper, ImGuiKey_ModSuper };
+	map[KEY_MENU]           = { ImGuiKey_Menu };
+	map[KEY_LEFTARROW]      = { ImGuiKey_LeftArrow };
+	map[KEY_DOWNARROW]      = { ImGuiKey_DownArrow };
+	map[KEY_UPARROW]        = { ImGuiKey_UpArrow };
+	map[KEY_RIGHTARROW]     = { ImGuiKey_RightArrow };
+	map[KEY_ENTER]          = { ImGuiKey_Enter };
+
+	return map;
+}();
+
+static bool ImGui_ImplGC_HasKey(const SIKeyboardStatus &kb, u8 si_key)
+{
+	return kb.keys[0] == si_key || kb.keys[1] == si_key || kb.keys[2] == si_key;
+}
+
+static void ImGui_ImplGC_SendKeyChanges(const SIKeyboardStatus &kb,
+                                        const SIKeyboardStatus &other_kb, bool down)
 {
-	auto pressed      = false;
-	auto pressed_last = false;
+	auto &io = ImGui::GetIO();
 
+	// Send events for keys in kb that aren't in other_kb
 	for (auto i = 0; i < 3; i++) {
-		pressed      = pressed      || kb.keys[i]      == si_key;
-		pressed_last = pressed_last || last_kb.keys[i] == si_key;
-	}
+		const auto si_key = kb.keys[i];
+		const auto &mapping = ImGui_ImplGC_KeyMap[si_key];
 
-	auto &io = ImGui::GetIO();
+		if (mapping.key == ImGuiKey_None || ImGui_ImplGC_HasKey(other_kb, si_key))
+			continue;
 
-	if (pressed && !pressed_last)
-		(io.AddKeyEvent(imgui_keys, true), ...);
-	else if (!pressed && pressed_last)
-		(io.AddKeyEvent(imgui_keys, false), ...);
+		io.AddKeyEvent(mapping.key, down);
+
+		if (mapping.mod != ImGuiKey_None)
+			io.AddKeyEvent(mapping.mod, down);
+	}
 }
 
 static void ImGui_ImplGC_CheckKeyboard(s32 chan)
@@ -90,116 +216,65 @@ static void ImGui_ImplGC_CheckKeyboard(s32 chan)
 	const auto &kb = bd->keyboard[chan];
 	const auto &last_kb = bd->last_keyboard[chan];
 
-	// Some of these are mapped differently due to keyboard layout
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_HOME,           ImGuiKey_Home);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_END,            ImGuiKey_End);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_PGUP,           ImGuiKey_PageUp);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_PGDN,           ImGuiKey_PageDown);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_SCROLLLOCK,     ImGuiKey_ScrollLock);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_A,              ImGuiKey_A);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_B,              ImGuiKey_B);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_C,              ImGuiKey_C);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_D,              ImGuiKey_D);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_E,              ImGuiKey_E);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F,              ImGuiKey_F);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_G,              ImGuiKey_G);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_H,              ImGuiKey_H);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_I,              ImGuiKey_I);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_J,              ImGuiKey_J);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_K,              ImGuiKey_K);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_L,              ImGuiKey_L);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_M,              ImGuiKey_M);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_N,              ImGuiKey_N);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_O,              ImGuiKey_O);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_P,              ImGuiKey_P);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_Q,              ImGuiKey_Q);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_R,              ImGuiKey_R);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_S,              ImGuiKey_S);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_T,              ImGuiKey_T);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_U,              ImGuiKey_U);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_V,              ImGuiKey_V);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_W,              ImGuiKey_W);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_X,              ImGuiKey_X);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_Y,              ImGuiKey_Y);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_Z,              ImGuiKey_Z);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_1,              ImGuiKey_1);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_2,              ImGuiKey_2);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_3,              ImGuiKey_3);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_4,              ImGuiKey_4);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_5,              ImGuiKey_5);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_6,              ImGuiKey_6);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_7,              ImGuiKey_7);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_8,              ImGuiKey_8);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_9,              ImGuiKey_9);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_0,              ImGuiKey_0);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_MINUS,          ImGuiKey_Minus);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_PLUS,           ImGuiKey_GraveAccent);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_PRINTSCR,       ImGuiKey_PrintScreen);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_BRACE_OPEN,     ImGuiKey_Apostrophe);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_BRACE_CLOSE,    ImGuiKey_LeftBracket);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_COLON,          ImGuiKey_Equal);
-
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_HASH,           ImGuiKey_RightBracket);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_COMMA,          ImGuiKey_Comma);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_PERIOD,         ImGuiKey_Period);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_QUESTIONMARK,   ImGuiKey_Slash);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_INTERNATIONAL1, ImGuiKey_Backslash);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F1,             ImGuiKey_F1);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F2,             ImGuiKey_F2);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F3,             ImGuiKey_F3);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F4,             ImGuiKey_F4);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F5,             ImGuiKey_F5);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F6,             ImGuiKey_F6);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F7,             ImGuiKey_F7);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F8,             ImGuiKey_F8);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F9,             ImGuiKey_F9);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F10,            ImGuiKey_F10);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F11,            ImGuiKey_F11);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_F12,            ImGuiKey_F12);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_ESC,            ImGuiKey_Escape);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_INSERT,         ImGuiKey_Insert);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_DELETE,         ImGuiKey_Delete);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_TILDE,          ImGuiKey_Semicolon);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_BACKSPACE,      ImGuiKey_Backspace);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_TAB,            ImGuiKey_Tab);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_CAPSLOCK,       ImGuiKey_CapsLock);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_LEFTSHIFT,      ImGuiKey_LeftShift,
-	                                                       ImGuiKey_ModShift);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_RIGHTSHIFT,     ImGuiKey_RightShift,
-	                                                       ImGuiKey_ModShift);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_LEFTCONTROL,    ImGuiKey_LeftCtrl,
-	                                                       ImGuiKey_ModCtrl);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_RIGHTALT,       ImGuiKey_RightAlt,
-	                                                       ImGuiKey_ModAlt);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_LEFTWINDOWS,    ImGuiKey_LeftSuper,
-	                                                       ImGuiKey_ModSuper);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_SPACE,          ImGuiKey_Space);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_RIGHTWINDOWS,   ImGuiKey_RightSuper,
-	                                                       ImGuiKey_ModSuper);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_MENU,           ImGuiKey_Menu);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_LEFTARROW,      ImGuiKey_LeftArrow);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_DOWNARROW,      ImGuiKey_DownArrow);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_UPARROW,        ImGuiKey_UpArrow);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_RIGHTARROW,     ImGuiKey_RightArrow);
-	ImGui_ImplGC_CheckKey(kb, last_kb, KEY_ENTER,          ImGuiKey_Enter);
+	ImGui_ImplGC_SendKeyChanges(last_kb, kb, false);
+	ImGui_ImplGC_SendKeyChanges(kb, last_kb, true);
 
 	bd->last_keyboard[chan] = kb;
 }
 
+static void ImGui_ImplGC_KeyboardCallback(s32 chan, u32 sr)
+{
+	auto &keyboard = keyboards[chan];
+
+	if (sr & SI_ERROR_MASK) {
+		// Check whether the keyboard was removed
+		keyboard.type_timer = 0;
+	} else {
+		keyboard.published = keyboard.published != 0 ? 0 : 1;
+	}
+
+	keyboard.busy = false;
+}
+
 static void ImGui_ImplGC_PollKeyboard(s32 chan)
 {
 	auto *bd = ImGui_ImplGC_GetBackendData();
+	auto &keyboard = keyboards[chan];
+
+	if (keyboard.type_timer-- <= 0) {
+		keyboard.type = SI_GetType(chan);
+		keyboard.type_timer = KEYBOARD_TYPE_INTERVAL;
+	}
 
-	if (SI_GetType(chan) != SI_GC_KEYBOARD) {
+	if (keyboard.type != SI_GC_KEYBOARD) {
 		bd->keyboard[chan]      = { 0 };
 		bd->last_keyboard[chan] = { 0 };
+		keyboard.published      = -1;
 		return;
 	}
 
-	// Request keyboard inputs
-	auto cmd_direct = 0x54000000;
-	SI_Transfer(chan, &cmd_direct, 1, &bd->keyboard[chan], sizeof(SIKeyboardStatus),
-	            [](s32, u32) {}, 0);
+	// Use the latest completed transfer
+	const auto enabled = OSDisableInterrupts();
+	const auto published = keyboard.published;
+	const auto busy = keyboard.busy;
+
+	if (published != -1)
+		bd->keyboard[chan] = keyboard.buffers[published];
+
+	if (!busy)
+		keyboard.busy = true;
+
+	OSRestoreInterrupts(enabled);
+
+	// Request keyboard inputs for next frame into the unpublished buffer
+	if (!busy) {
+		static const u32 cmd_direct = 0x54000000;
+		auto *buffer = &keyboard.buffers[published != 0 ? 0 : 1];
+
+		if (!SI_Transfer(chan, (void*)&cmd_direct, 1, buffer, sizeof(SIKeyboardStatus),
+		                 ImGui_ImplGC_KeyboardCallback, 0))
+			keyboard.busy = false;
+	}
 
 	ImGui_ImplGC_CheckKeyboard(chan);
 }
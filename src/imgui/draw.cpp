@@ -1,15 +1,11 @@
 #include "imgui/events.h"
 #include "imgui/backends/imgui_impl_gc.h"
 #include "imgui/backends/imgui_impl_gx.h"
-#include "util/hooks.h"
+#include "render/events.h"
 #include <imgui.h>
 
-extern "C" void GObj_RenderAll();
-
-HOOK(GObj_RenderAll, [&]()
+EVENT_HANDLER(events::render::post, []()
 {
-	original();
-
 	if (ImGui::GetCurrentContext() == nullptr)
 		return;
 
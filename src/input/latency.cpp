@@ -0,0 +1,179 @@
+#include "dolphin/serial.h"
+#include "console/console.h"
+#include "console/cvar.h"
+#include "imgui/events.h"
+#include "input/poll.h"
+#include "player/events.h"
+#include "util/hash.h"
+#include "util/histogram.h"
+#include "util/time.h"
+#include <cfloat>
+#include <cstdio>
+#include <cstdlib>
+#include <imgui.h>
+
+// Drop a press if no AS change follows within this many frames
+constexpr auto PRESS_TIMEOUT = 10;
+
+struct latency_stats {
+	// Time between consecutive polls, in microseconds
+	histogram<64> interval = histogram<64>(250);
+	// Index within its frame of the poll given to the game
+	histogram<MAX_POLLS_PER_FRAME> sample = histogram<MAX_POLLS_PER_FRAME>(1);
+	// Time from the first poll with a new press to the AS change after it, in microseconds
+	histogram<96> press = histogram<96>(500);
+
+	u64 last_poll_time;
+	u16 last_buttons;
+	u64 press_time;
+
+	void clear()
+	{
+		interval.clear();
+		sample.clear();
+		press.clear();
+		last_poll_time = 0;
+		press_time = 0;
+	}
+};
+
+static latency_stats stats[4];
+
+static console::cvar<int> latency_panel("latency_panel", {
+	.value = 0, .min = 0, .max = 1
+});
+
+EVENT_HANDLER(events::input::deferred_poll, [](const poll_record &poll)
+{
+	if (poll.status.errstat != 0)
+		return;
+
+	auto &port = stats[poll.chan];
+	const auto time = poll.timestamp.time;
+
+	if (port.last_poll_time != 0)
+		port.interval.add(ticks_to_us(time - port.last_poll_time));
+
+	port.last_poll_time = time;
+
+	// Only time the first press until something happens
+	const auto pressed = poll.status.buttons & ~port.last_buttons;
+	port.last_buttons = poll.status.buttons;
+
+	if (pressed != 0 && port.press_time == 0)
+		port.press_time = time;
+});
+
+EVENT_HANDLER(events::input::sample, [](s32 chan, s32 poll_index, const poll_timestamp &timestamp)
+{
+	stats[chan].sample.add((u32)poll_index);
+});
+
+EVENT_HANDLER(events::player::as_change, [](Player *player, u32 old_state, u32 new_state)
+{
+	if (player->port >= 4)
+		return;
+
+	auto &port = stats[player->port];
+	if (port.press_time == 0)
+		return;
+
+	const auto delay = get_time() - port.press_time;
+	if (delay <= (u64)FRAME_TICKS * PRESS_TIMEOUT)
+		port.press.add(ticks_to_us(delay));
+
+	port.press_time = 0;
+});
+
+EVENT_HANDLER(events::player::think::input::pre, [](Player *player)
+{
+	if (player->port >= 4)
+		return;
+
+	// Forget presses that never caused an AS change
+	auto &port = stats[player->port];
+	const auto press_time = port.press_time;
+
+	if (press_time != 0 && get_time() - press_time > (u64)FRAME_TICKS * PRESS_TIMEOUT)
+		port.press_time = 0;
+});
+
+template<size_t N>
+static void plot_histogram(const char *label, const histogram<N> &hist, const char *unit)
+{
+	const auto getter = [](void *data, int index) {
+		return (float)static_cast<const histogram<N>*>(data)->get((size_t)index);
+	};
+
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "mean %u%s  p99 %u%s  max %u%s",
+	         hist.mean(), unit, hist.percentile(99), unit, hist.max(), unit);
+
+	ImGui::PlotHistogram(label, getter, const_cast<histogram<N>*>(&hist), (int)N, 0, overlay,
+	                     0.f, FLT_MAX, {300, 50});
+}
+
+EVENT_HANDLER(events::imgui::draw, []()
+{
+	if (!latency_panel.get())
+		return;
+
+	ImGui::SetNextWindowPos({320, 30}, ImGuiCond_FirstUseEver);
+	ImGui::Begin("Latency", nullptr, ImGuiWindowFlags_NoNav
+	                               | ImGuiWindowFlags_AlwaysAutoResize);
+
+	for (auto chan = 0; chan < 4; chan++) {
+		const auto &port = stats[chan];
+		if (port.interval.count() == 0)
+			continue;
+
+		ImGui::Text("Port %d", chan + 1);
+		plot_histogram("Poll interval", port.interval, "us");
+		plot_histogram("Sampled poll", port.sample, "");
+		plot_histogram("Press to AS", port.press, "us");
+	}
+
+	ImGui::End();
+});
+
+template<size_t N>
+static void dump_histogram(const char *name, const histogram<N> &hist)
+{
+	console::printf("%s: %u samples, mean %u, p50 %u, p99 %u, max %u", name,
+	                hist.count(), hist.mean(), hist.percentile(50), hist.percentile(99),
+	                hist.max());
+
+	for (size_t i = 0; i < N; i++) {
+		if (hist.get(i) == 0)
+			continue;
+
+		const auto size = hist.get_bucket_size();
+		console::printf("  %6u-%-6u %u", (u32)i * size, (u32)(i + 1) * size, hist.get(i));
+	}
+}
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	if (cmd_hash == hash<"latency_clear">()) {
+		for (auto &port : stats)
+			port.clear();
+
+		return true;
+	}
+
+	if (cmd_hash != hash<"latency_dump">())
+		return false;
+
+	const auto chan = argc >= 2 ? strtol(argv[1], nullptr, 0) - 1 : 0;
+
+	if (chan < 0 || chan >= 4) {
+		console::print("Expected a port from 1 to 4.");
+		return true;
+	}
+
+	const auto &port = stats[chan];
+	dump_histogram("Poll interval (us)", port.interval);
+	dump_histogram("Sampled poll", port.sample);
+	dump_histogram("Press to AS (us)", port.press);
+	return true;
+});
\ No newline at end of file
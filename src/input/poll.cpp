@@ -1,31 +1,279 @@
+#include "dolphin/os.h"
 #include "dolphin/serial.h"
 #include "dolphin/vi.h"
+#include "hsd/pad.h"
+#include "melee/player.h"
 #include "console/console.h"
 #include "console/cvar.h"
 #include "input/poll.h"
+#include "input/select.h"
+#include "match/events.h"
+#include "player/events.h"
+#include "render/events.h"
 #include "util/hash.h"
 #include "util/hooks.h"
+#include "util/time.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 
-static s32 poll_index[4];
-static u32 last_retrace_count[4];
-static SIPadStatus status[4];
+// Number of recent retrace times to remember
+constexpr size_t RETRACE_HISTORY = 64;
+// Frames to observe before the automatic mode changes the polling rate
+constexpr auto AUTO_WINDOW = 60;
+// Longer gaps between rendered frames are pauses like loading screens rather than lag
+constexpr u32 AUTO_MAX_LAG_RETRACES = 4;
+
+static void set_manual_polling_mult(int mult);
 
 static console::cvar<int> polling_mult("polling_mult", {
 	.value = 10, .min = 1, .max = MAX_POLLS_PER_FRAME / 2,
-	.set = [](int) {
-		// Force polling rate update
-		const auto sipoll = Si.poll.raw;
-		SI_SetSamplingRate(16);
-		SI_DisablePolling(0b11110000 << 24);
-		SI_EnablePolling(sipoll << 24);
+	.set = [](int value) {
+		set_manual_polling_mult(value);
 	}});
 
+static s32 poll_index[4];
+static u32 last_retrace_count[4];
+
+// Multiplier currently applied by SI_SetXY
+static int current_mult = polling_mult.get();
+
+// Channels that get per-poll processing, the rest only keep the vanilla 120Hz samples
+static u32 oversampled_ports = 0b1111;
+
+// Time spent handling polls during the current and previous VI frames
+static u32 frame_retrace_count;
+static u32 frame_poll_ticks;
+static u32 last_frame_poll_ticks;
+
+static struct {
+	u32 retrace_count;
+	u64 time;
+} retrace_history[RETRACE_HISTORY];
+
+static struct {
+	u32 retrace_count;
+	int frames;
+	s32 min_slack;
+	u32 max_poll_ticks;
+} controller;
+
+u64 get_retrace_time(u32 retrace_count)
+{
+	const auto &entry = retrace_history[retrace_count % RETRACE_HISTORY];
+	return entry.retrace_count == retrace_count ? entry.time : 0;
+}
+
+static float get_frame_offset(const poll_timestamp &timestamp, u64 retrace_time)
+{
+	// Use the measured frame length if the following retrace has happened
+	const auto next_retrace_time = get_retrace_time(timestamp.retrace_count + 1);
+	const auto length = next_retrace_time != 0 ? next_retrace_time - retrace_time : FRAME_TICKS;
+	return (float)(s64)(timestamp.time - retrace_time) / (float)length;
+}
+
+float get_frame_delta(const poll_timestamp &from, const poll_timestamp &to)
+{
+	const auto from_retrace_time = get_retrace_time(from.retrace_count);
+	const auto to_retrace_time = get_retrace_time(to.retrace_count);
+
+	if (from_retrace_time == 0 || to_retrace_time == 0)
+		return (float)(s64)(to.time - from.time) / (float)FRAME_TICKS;
+
+	return (float)(s32)(to.retrace_count - from.retrace_count)
+	     + get_frame_offset(to, to_retrace_time)
+	     - get_frame_offset(from, from_retrace_time);
+}
+
+static int get_effective_mult()
+{
+	// Don't raise the bus poll rate if no channel will use it
+	return oversampled_ports != 0 ? current_mult : 1;
+}
+
+static void apply_polling_mult(int mult)
+{
+	current_mult = mult;
+
+	// Force polling rate update
+	const auto sipoll = Si.poll.raw;
+	SI_SetSamplingRate(16);
+	SI_DisablePolling(0b11110000 << 24);
+	SI_EnablePolling(sipoll << 24);
+}
+
+static void reset_controller()
+{
+	controller.frames = 0;
+	controller.min_slack = (s32)FRAME_TICKS;
+	controller.max_poll_ticks = 0;
+}
+
+// Automatically pick the highest multiplier in [polling_auto_min, polling_auto_max] that leaves
+// at least polling_auto_margin microseconds of slack in every frame
+static console::cvar<int> polling_auto("polling_auto", {
+	.value = 0, .min = 0, .max = 1,
+	.set = [](int value) {
+		reset_controller();
+		apply_polling_mult(polling_mult.get());
+	}});
+
+// polling_mult only applies while the automatic mode is off
+static void set_manual_polling_mult(int mult)
+{
+	if (!polling_auto.get())
+		apply_polling_mult(mult);
+}
+
+static console::cvar<int> polling_auto_min("polling_auto_min", {
+	.value = 1, .min = 1, .max = MAX_POLLS_PER_FRAME / 2
+});
+
+static console::cvar<int> polling_auto_max("polling_auto_max", {
+	.value = MAX_POLLS_PER_FRAME / 2, .min = 1, .max = MAX_POLLS_PER_FRAME / 2
+});
+
+static console::cvar<int> polling_auto_margin("polling_auto_margin", {
+	.value = 2000, .min = 0, .max = 16000
+});
+
+static void update_oversampled_ports();
+
+// Bitmask of ports to oversample, or -1 for ports with a human player
+static console::cvar<int> oversample_ports("oversample_ports", {
+	.value = -1, .min = -1, .max = 0b1111,
+	.set = [](int value) {
+		update_oversampled_ports();
+	}});
+
+static u32 get_oversampled_ports()
+{
+	if (oversample_ports.get() != -1)
+		return (u32)oversample_ports.get();
+
+	auto mask = 0u;
+
+	for (auto i = 0; i < 4; i++) {
+		if (PlayerBlock_GetSlotType(i) == SlotType_Human)
+			mask |= 1u << i;
+	}
+
+	return mask;
+}
+
+static void update_oversampled_ports()
+{
+	const auto mask = get_oversampled_ports();
+	const auto was_enabled = oversampled_ports != 0;
+	oversampled_ports = mask;
+
+	if ((mask != 0) != was_enabled)
+		apply_polling_mult(current_mult);
+}
+
+static void step_polling_mult(int delta)
+{
+	const auto min = polling_auto_min.get();
+	const auto max = std::max(min, polling_auto_max.get());
+	const auto mult = std::clamp(current_mult + delta, min, max);
+
+	if (mult != current_mult)
+		apply_polling_mult(mult);
+}
+
+// Handle queued polls before anything looks at input for the frame
+HOOK_CHAIN(PlayerThink_Input, -1, [&](HSD_GObj *gobj)
+{
+	events::input::deferred_poll.drain();
+	original(gobj);
+});
+
+// Slot types only change between matches
+EVENT_HANDLER(events::match::enter, []()
+{
+	update_oversampled_ports();
+});
+
+EVENT_HANDLER(events::match::exit, []()
+{
+	update_oversampled_ports();
+});
+
+EVENT_HANDLER(events::render::post, []()
+{
+	// Keep the queue from filling up when no players are thinking
+	events::input::deferred_poll.drain();
+
+	const auto now = get_ticks();
+	const auto retrace_count = VIGetRetraceCount();
+	const auto retraces = retrace_count - controller.retrace_count;
+	controller.retrace_count = retrace_count;
+
+	if (!polling_auto.get() || oversampled_ports == 0)
+		return;
+
+	if (retraces > AUTO_MAX_LAG_RETRACES) {
+		// Nothing was rendered in between, start a new window without judging this frame
+		reset_controller();
+		return;
+	}
+
+	if (retraces > 1) {
+		// Back off immediately on a lag frame
+		step_polling_mult(-1);
+		reset_controller();
+		return;
+	}
+
+	// The retrace is missing from the history if the hook hasn't seen it, don't judge this frame
+	const auto retrace_time = get_retrace_time(retrace_count);
+	if (retrace_time == 0)
+		return;
+
+	// Time left until the next retrace
+	const auto slack = (s32)(FRAME_TICKS - (now - (u32)retrace_time));
+	controller.min_slack = std::min(controller.min_slack, slack);
+	controller.max_poll_ticks = std::max(controller.max_poll_ticks, last_frame_poll_ticks);
+
+	if (++controller.frames < AUTO_WINDOW)
+		return;
+
+	// Worst case cost of raising the multiplier by one
+	const auto margin = (s32)us_to_ticks((u32)polling_auto_margin.get());
+	const auto step_cost = (s32)(controller.max_poll_ticks / (u32)current_mult);
+
+	if (controller.min_slack < margin)
+		step_polling_mult(-1);
+	else if (controller.min_slack - step_cost > margin)
+		step_polling_mult(1);
+
+	reset_controller();
+});
+
+extern "C" void __VIRetraceHandler(s16 interrupt, OSContext *context);
+
+HOOK(__VIRetraceHandler, [&](s16 interrupt, OSContext *context)
+{
+	// Timestamp on entry, before the handler runs the game's retrace callbacks
+	const auto time = get_time();
+	const auto old_retrace_count = VIGetRetraceCount();
+	original(interrupt, context);
+
+	// The handler also runs for display interrupts other than retrace
+	const auto retrace_count = VIGetRetraceCount();
+	if (retrace_count == old_retrace_count)
+		return;
+
+	retrace_history[retrace_count % RETRACE_HISTORY] = {
+		.retrace_count = retrace_count,
+		.time          = time
+	};
+});
+
 HOOK(SI_SetXY, [&](u16 line, u8 cnt)
 {
 	// Change poll interval so the middle poll happens when it would on vanilla
-	const auto new_cnt = (u8)std::min(cnt * polling_mult.get(), MAX_POLLS_PER_FRAME);
+	const auto new_cnt = (u8)std::min(cnt * get_effective_mult(), MAX_POLLS_PER_FRAME);
 	const auto progressive = vi_regs->viclk.s != 0;
 
 	if (progressive)
@@ -36,6 +284,8 @@ HOOK(SI_SetXY, [&](u16 line, u8 cnt)
 
 HOOK(SI_GetResponseRaw, [&](s32 chan)
 {
+	const auto time = get_time();
+	const auto start_ticks = (u32)time;
 	const auto result = original(chan);
 	const auto &new_status = SILastPadStatus[chan];
 
@@ -43,24 +293,50 @@ HOOK(SI_GetResponseRaw, [&](s32 chan)
 	if (retrace_count > last_retrace_count[chan])
 		poll_index[chan] = 0;
 
-	events::input::poll.fire(chan, new_status);
+	if (retrace_count != frame_retrace_count) {
+		frame_retrace_count = retrace_count;
+		last_frame_poll_ticks = frame_poll_ticks;
+		frame_poll_ticks = 0;
+	}
 
-	// Store the polls that would happen at 120Hz
-	if (poll_index[chan] == 0 || poll_index[chan] == Si.poll.y / 2)
-		status[chan] = new_status;
+	const auto timestamp = poll_timestamp {
+		.time          = time,
+		.retrace_count = retrace_count
+	};
+
+	const auto oversampled = (oversampled_ports & (1u << chan)) != 0;
+
+	if (oversampled) {
+		events::input::deferred_poll.fire({
+			.chan      = chan,
+			.status    = new_status,
+			.timestamp = timestamp,
+			.qwrite    = HSD_PadLibData.qwrite
+		});
+	}
+
+	select_poll(chan, oversampled, new_status, poll_index[chan], timestamp);
 
 	poll_index[chan]++;
 	last_retrace_count[chan] = retrace_count;
 
+	if (oversampled)
+		frame_poll_ticks += get_ticks() - start_ticks;
+
 	return result;
 });
 
 HOOK(SI_GetResponse, [&](s32 chan, void *buf)
 {
-	// Use 120Hz polls
 	const auto result = original(chan, buf);
-	if (result && polling_mult.get() != 1)
-		*(SIPadStatus*)buf = status[chan];
+	if (!result)
+		return result;
+
+	// Replace the latest poll with the selected one
+	const auto selected = take_selected_poll(chan);
+	if (get_effective_mult() != 1)
+		*(SIPadStatus*)buf = selected.status;
 
+	events::input::sample.fire(chan, selected.poll_index, selected.timestamp);
 	return result;
 });
\ No newline at end of file
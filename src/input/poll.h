@@ -2,9 +2,38 @@
 
 #include "dolphin/serial.h"
 #include "event/event.h"
+#include "util/time.h"
 
 constexpr auto MAX_POLLS_PER_FRAME = 32;
 
+// Length of an NTSC frame
+constexpr u32 FRAME_TICKS = (u32)((u64)TIMEBASE_FREQUENCY * 1001 / 60000);
+
+struct poll_timestamp {
+	// Time base when the poll was received
+	u64 time;
+	// VI retrace count when the poll was received
+	u32 retrace_count;
+};
+
+// Poll queued from the SI interrupt
+struct poll_record {
+	s32 chan;
+	SIPadStatus status;
+	poll_timestamp timestamp;
+	// PAD queue index being written when the poll was received
+	u8 qwrite;
+};
+
 namespace events::input {
-inline event<void(s32 chan, const SIPadStatus &pad)> poll;
-} // events::input
\ No newline at end of file
+// Polls queued from the SI interrupt, drained before PlayerThink_Input and after rendering
+inline deferred_event<poll_record, 256> deferred_poll;
+// Fired when the game reads a controller, with the index of the poll it was given in its frame
+inline event<void(s32 chan, s32 poll_index, const poll_timestamp &timestamp)> sample;
+} // events::input
+
+// Time base when a recent VI retrace happened, or 0 if it's no longer known
+u64 get_retrace_time(u32 retrace_count);
+
+// Time in frames between two polls, measured relative to the retraces they fell after
+float get_frame_delta(const poll_timestamp &from, const poll_timestamp &to);
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include "dolphin/os.h"
+#include "dolphin/serial.h"
+#include "console/console.h"
+#include "console/cvar.h"
+#include "input/poll.h"
+#include "input/select.h"
+#include "util/hash.h"
+#include <algorithm>
+#include <cstdlib>
+#include <type_traits>
+
+struct selector_state {
+	selected_poll selected;
+	// Buttons from the last poll read by the game
+	u16 delivered_buttons;
+	// Whether a poll with a button edge has been selected since the game last read
+	bool edge_found;
+	// Last three stick values for median filtering
+	SIPadStatus history[3];
+	size_t history_index;
+};
+
+struct poll_selector {
+	const char *name;
+	// Called for every poll with bounded cost
+	void(*update)(selector_state *state, const SIPadStatus &status, s32 poll_index,
+	              const poll_timestamp &timestamp);
+};
+
+static void select(selector_state *state, const SIPadStatus &status, s32 poll_index,
+                   const poll_timestamp &timestamp)
+{
+	state->selected = {
+		.status     = status,
+		.poll_index = poll_index,
+		.timestamp  = timestamp
+	};
+}
+
+static s8 median(s8 a, s8 b, s8 c)
+{
+	return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+static const poll_selector selectors[] = {
+	{
+		// Use the polls that would happen at 120Hz
+		.name = "vanilla",
+		.update = [](selector_state *state, const SIPadStatus &status, s32 poll_index,
+		             const poll_timestamp &timestamp) {
+			if (poll_index == 0 || poll_index == Si.poll.y / 2)
+				select(state, status, poll_index, timestamp);
+		}
+	},
+	{
+		// Always use the most recent poll
+		.name = "newest",
+		.update = [](selector_state *state, const SIPadStatus &status, s32 poll_index,
+		             const poll_timestamp &timestamp) {
+			select(state, status, poll_index, timestamp);
+		}
+	},
+	{
+		// Hold the first poll with a button change since the last read, otherwise the newest
+		.name = "first_edge",
+		.update = [](selector_state *state, const SIPadStatus &status, s32 poll_index,
+		             const poll_timestamp &timestamp) {
+			if (state->edge_found)
+				return;
+
+			select(state, status, poll_index, timestamp);
+			state->edge_found = status.buttons != state->delivered_buttons;
+		}
+	},
+	{
+		// Use the newest buttons and triggers with the median of the last three stick values
+		.name = "median",
+		.update = [](selector_state *state, const SIPadStatus &status, s32 poll_index,
+		             const poll_timestamp &timestamp) {
+			auto &history = state->history;
+			history[state->history_index++ % 3] = status;
+
+			select(state, status, poll_index, timestamp);
+
+			auto &stick = state->selected.status.stick;
+			auto &cstick = state->selected.status.cstick;
+			stick.x  = median(history[0].stick.x,  history[1].stick.x,  history[2].stick.x);
+			stick.y  = median(history[0].stick.y,  history[1].stick.y,  history[2].stick.y);
+			cstick.x = median(history[0].cstick.x, history[1].cstick.x, history[2].cstick.x);
+			cstick.y = median(history[0].cstick.y, history[1].cstick.y, history[2].cstick.y);
+		}
+	},
+};
+
+constexpr auto selector_count = (int)std::extent_v<decltype(selectors)>;
+
+static selector_state states[4];
+
+// Index into selectors for each port. 0 = vanilla, 1 = newest, 2 = first_edge, 3 = median
+static console::cvar<int> poll_select[] = {
+	console::cvar<int>("poll_select_1", { .value = 0, .min = 0, .max = selector_count - 1 }),
+	console::cvar<int>("poll_select_2", { .value = 0, .min = 0, .max = selector_count - 1 }),
+	console::cvar<int>("poll_select_3", { .value = 0, .min = 0, .max = selector_count - 1 }),
+	console::cvar<int>("poll_select_4", { .value = 0, .min = 0, .max = selector_count - 1 }),
+};
+
+// Selector indices by name for the poll_select command
+static constexpr static_map<int, "vanilla", "newest", "first_edge", "median"> selector_indices({
+	0, 1, 2, 3
+});
+
+static_assert(selector_indices.size() == selector_count);
+
+void select_poll(s32 chan, bool oversampled, const SIPadStatus &status, s32 poll_index,
+                 const poll_timestamp &timestamp)
+{
+	const auto &selector = selectors[oversampled ? poll_select[chan].get() : 0];
+	selector.update(&states[chan], status, poll_index, timestamp);
+}
+
+selected_poll take_selected_poll(s32 chan)
+{
+	// Polls may arrive while the game is reading
+	const auto enabled = OSDisableInterrupts();
+	auto &state = states[chan];
+	const auto selected = state.selected;
+	state.delivered_buttons = selected.status.buttons;
+	state.edge_found = false;
+	OSRestoreInterrupts(enabled);
+
+	return selected;
+}
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	if (cmd_hash != hash<"poll_select">())
+		return false;
+
+	const auto chan = argc >= 3 ? strtol(argv[1], nullptr, 0) - 1 : -1;
+	const auto *index = argc >= 3 ? selector_indices.find(argv[2]) : nullptr;
+
+	if (chan < 0 || chan >= 4 || index == nullptr) {
+		console::print("Usage: poll_select <port 1-4> <vanilla|newest|first_edge|median>");
+		return true;
+	}
+
+	poll_select[chan].set(*index);
+	return true;
+});
\ No newline at end of file
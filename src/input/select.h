@@ -0,0 +1,19 @@
+#pragma once
+
+#include "dolphin/serial.h"
+#include "input/poll.h"
+
+// The poll chosen to be read by the game for a port
+struct selected_poll {
+	SIPadStatus status;
+	s32 poll_index;
+	poll_timestamp timestamp;
+};
+
+// Feed a poll to the port's selection strategy. Runs in the SI interrupt.
+// Ports that aren't oversampled always use vanilla 120Hz selection.
+void select_poll(s32 chan, bool oversampled, const SIPadStatus &status, s32 poll_index,
+                 const poll_timestamp &timestamp);
+
+// Get the poll to give to the game and start looking for edges relative to it
+selected_poll take_selected_poll(s32 chan);
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <gctypes.h>
+
+namespace labscript {
+
+// Bump allocator for the nodes of a single script. Nodes are allocated in decode order, which
+// places each script's tree in memory in pre-order.
+class arena {
+	u8 *data = nullptr;
+	size_t size = 0;
+	size_t offset = 0;
+
+public:
+	arena() = default;
+
+	arena(void *data, size_t size) : data((u8*)data), size(size)
+	{
+	}
+
+	void *get_data() const
+	{
+		return data;
+	}
+
+	size_t get_size() const
+	{
+		return size;
+	}
+
+	size_t get_used() const
+	{
+		return offset;
+	}
+
+	void *allocate(size_t alloc_size, size_t alignment)
+	{
+		const auto start = (offset + alignment - 1) & ~(alignment - 1);
+
+		if (start + alloc_size > size)
+			return nullptr;
+
+		offset = start + alloc_size;
+		return &data[start];
+	}
+
+	// Size an arena needs to hold an allocation given the current usage
+	static size_t grow(size_t used, size_t alloc_size, size_t alignment)
+	{
+		return ((used + alignment - 1) & ~(alignment - 1)) + alloc_size;
+	}
+};
+
+} // namespace labscript
\ No newline at end of file
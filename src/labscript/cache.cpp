@@ -0,0 +1,105 @@
+#include "dolphin/vi.h"
+#include "match/events.h"
+#include "labscript/cache.h"
+#include "labscript/expression.h"
+#include <cstring>
+#include <gctypes.h>
+
+namespace labscript::cache {
+
+// Must be a power of two
+constexpr size_t CACHE_SIZE = 64;
+
+struct entry {
+	hash_t hash;
+	cache_scope scope;
+	// Retrace count when stored, for frame scope
+	u32 retrace_count;
+	// Value of match_epoch when stored
+	u32 match_epoch;
+	u8 value[MAX_RESULT_SIZE];
+};
+
+// Direct mapped by hash, collisions evict
+static entry entries[CACHE_SIZE];
+
+// Incremented on match events. Starts at 1 so zeroed entries are invalid.
+static u32 match_epoch = 1;
+
+static size_t get_result_size(type type)
+{
+	switch (type) {
+	case type::s32:    return sizeof(s32);
+	case type::f32:    return sizeof(f32);
+	case type::player: return sizeof(void*);
+	default:           return 0;
+	}
+}
+
+bool lookup(hash_t hash, void *result)
+{
+	const auto &entry = entries[hash % CACHE_SIZE];
+
+	if (entry.hash != hash || entry.match_epoch != match_epoch)
+		return false;
+
+	if (entry.scope == cache_scope::frame && entry.retrace_count != VIGetRetraceCount())
+		return false;
+
+	if (result != nullptr)
+		memcpy(result, entry.value, sizeof(entry.value));
+
+	return true;
+}
+
+void store(hash_t hash, cache_scope scope, const void *result, size_t size)
+{
+	auto &entry = entries[hash % CACHE_SIZE];
+	entry.hash = hash;
+	entry.scope = scope;
+	entry.retrace_count = VIGetRetraceCount();
+	entry.match_epoch = match_epoch;
+	memcpy(entry.value, result, size);
+}
+
+void invalidate()
+{
+	match_epoch++;
+}
+
+} // namespace labscript::cache
+
+namespace labscript {
+
+result expression::evaluate(void *result) const
+{
+	const auto scope = get_cache_scope();
+
+	if (scope == cache_scope::none || input != nullptr)
+		return execute(result);
+
+	const auto hash = get_hash();
+	const auto size = cache::get_result_size(get_type());
+
+	// Execute into a full size buffer so the result can be both cached and returned
+	u8 value[cache::MAX_RESULT_SIZE];
+
+	if (!cache::lookup(hash, value)) {
+		if (const auto error = execute(value); error != result::ok)
+			return error;
+
+		cache::store(hash, scope, value, size);
+	}
+
+	if (result != nullptr)
+		memcpy(result, value, size);
+
+	return result::ok;
+}
+
+} // namespace labscript
+
+EVENT_HANDLER(events::match::exit, []()
+{
+	labscript::cache::invalidate();
+});
\ No newline at end of file
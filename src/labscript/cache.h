@@ -0,0 +1,21 @@
+#pragma once
+
+#include "labscript/expression.h"
+#include "util/hash.h"
+#include <gctypes.h>
+
+namespace labscript::cache {
+
+// Cached results must fit in this many bytes, pointers are wider on 64-bit hosts
+constexpr size_t MAX_RESULT_SIZE = sizeof(void*) > sizeof(u32) ? sizeof(void*) : sizeof(u32);
+
+// Copy a valid cached result for the expression hash into a MAX_RESULT_SIZE buffer.
+// Returns false on a miss.
+bool lookup(hash_t hash, void *result);
+
+void store(hash_t hash, cache_scope scope, const void *result, size_t size);
+
+// Invalidate every cached result
+void invalidate();
+
+} // namespace labscript::cache
\ No newline at end of file
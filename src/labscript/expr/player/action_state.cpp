@@ -0,0 +1,33 @@
+#include "melee/player.h"
+#include "labscript/expression.h"
+#include "labscript/internal.h"
+
+namespace labscript::expr {
+
+struct player_action_state : expression {
+	hash_t get_hash() const override
+	{
+		return hash<"player_action_state">();
+	}
+
+	type get_type() const override
+	{
+		return type::s32;
+	}
+
+	result execute(void *result) const override
+	{
+		// Inputs such as human_player are shared through the cache
+		Player *player;
+		if (const auto error = evaluate_input(input, type::player, &player); error != result::ok)
+			return error;
+
+		set_result(result, player != nullptr ? (s32)player->action_state : -1);
+		return result::ok;
+	}
+};
+
+LABSCRIPT_EXPR_TYPE(player_action_state, "Action State",
+                    "Get the current action state of a player, or -1 if there is none.");
+
+} // namespace labscript::expr
\ No newline at end of file
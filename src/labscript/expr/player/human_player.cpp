@@ -17,6 +17,11 @@ struct human_player : expression {
 		return type::player;
 	}
 
+	cache_scope get_cache_scope() const override
+	{
+		return cache_scope::frame;
+	}
+
 	result execute(void *result) const override
 	{
 		Player *player = nullptr;
@@ -0,0 +1,56 @@
+#include "labscript/expression.h"
+#include "labscript/internal.h"
+#include "labscript/serialize.h"
+#include <gctypes.h>
+
+namespace labscript::expr {
+
+template<typename T, type result_type>
+struct literal : expression {
+	T value;
+
+	type get_type() const override
+	{
+		return result_type;
+	}
+
+	result execute(void *result) const override
+	{
+		set_result(result, value);
+		return result::ok;
+	}
+
+	size_t get_payload_size() const override
+	{
+		return sizeof(T);
+	}
+
+	void encode(writer *writer) const override
+	{
+		writer->write(value);
+	}
+
+	result decode(reader *reader) override
+	{
+		return reader->read(&value) ? result::ok : result::bad_format;
+	}
+};
+
+struct s32_literal : literal<s32, type::s32> {
+	hash_t get_hash() const override
+	{
+		return hash<"s32_literal">();
+	}
+};
+
+struct f32_literal : literal<f32, type::f32> {
+	hash_t get_hash() const override
+	{
+		return hash<"f32_literal">();
+	}
+};
+
+LABSCRIPT_EXPR_TYPE(s32_literal, "Integer", "A constant integer value.");
+LABSCRIPT_EXPR_TYPE(f32_literal, "Float", "A constant floating point value.");
+
+} // namespace labscript::expr
\ No newline at end of file
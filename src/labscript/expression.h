@@ -3,16 +3,26 @@
 #include "labscript/result.h"
 #include "util/hash.h"
 #include "util/preprocessor.h"
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
 
 #define LABSCRIPT_EXPR_TYPE(type, name, description)                                               \
 	namespace CONCAT(_expr_type_, __COUNTER__) {                                               \
-	static auto new_type = expr_type(name, description,                                        \
-	                                 [] { return static_cast<expression*>(new type); });       \
+	static_assert(std::is_trivially_destructible_v<type>,                                      \
+	              "Expressions are freed along with their script without being destroyed");    \
+	static auto new_type = expr_type(                                                          \
+		hash<#type>(), name, description, sizeof(type), alignof(type),                     \
+		[](void *memory) { return static_cast<expression*>(new (memory) type()); });       \
 	}                                                                                          \
 	static_assert(true) // Force semicolon
 
 namespace labscript {
 
+class reader;
+class writer;
+
 enum class type {
 	none,   // void
 	s32,    // int
@@ -20,6 +30,13 @@ enum class type {
 	player, // Player*
 };
 
+// How long an expression's result stays valid once computed
+enum class cache_scope {
+	none,  // Recompute on every evaluation
+	frame, // Until the next frame or match event
+	match, // Until the next match event
+};
+
 struct expression {
 	// Next expression within this scope.
 	expression *next;
@@ -28,7 +45,7 @@ struct expression {
 	// The first expression passed as an argument to this expression.
 	expression *input;
 
-	virtual ~expression() = default;
+	// No virtual destructor, scripts free their nodes all at once without destroying them.
 
 	// Get a unique hash to be used for encoding.
 	virtual hash_t get_hash() const = 0;
@@ -45,27 +62,93 @@ struct expression {
 	{
 		return false;
 	}
+
+	// Pure expressions with no inputs or payload may return a scope to share their result
+	// between every instance in every script until it's invalidated.
+	virtual cache_scope get_cache_scope() const
+	{
+		return cache_scope::none;
+	}
+
+	// Like execute, but uses a cached result if one is still valid.
+	result evaluate(void *result) const;
+
+	// Size of the literal data written by encode. Must be below MAX_PAYLOAD_SIZE.
+	virtual size_t get_payload_size() const
+	{
+		return 0;
+	}
+
+	// Write literal data following the node in the binary format.
+	virtual void encode(writer *writer) const
+	{
+	}
+
+	// Read literal data written by encode.
+	virtual result decode(reader *reader)
+	{
+		return result::ok;
+	}
 };
 
 struct expr_type {
-	using constructor_t = expression*();
+	using constructor_t = expression*(void *memory);
+
+	// Must be a power of two
+	static constexpr size_t TABLE_SIZE = 256;
 
-	inline static expr_type *head;
+	// Open addressed by hash
+	inline static expr_type *table[TABLE_SIZE];
 
-	// Next expression type in list
-	expr_type *next;
+	// Hash returned by get_hash
+	const hash_t hash;
 	// Pretty name for UI display
 	const char *const name;
 	// Pretty description for UI display
 	const char *const description;
-	// Function to create an instance of this expression
+	// sizeof/alignof the expression for arena allocation
+	const size_t size;
+	const size_t alignment;
+	// Function to construct an instance of this expression in memory of the above size
 	constructor_t *const constructor;
 
-	expr_type(const char *name, const char *description, constructor_t *constructor)
-		: name(name), description(description), constructor(constructor)
+	expr_type(hash_t hash, const char *name, const char *description,
+	          size_t size, size_t alignment, constructor_t *constructor)
+		: hash(hash), name(name), description(description),
+		  size(size), alignment(alignment), constructor(constructor)
 	{
-		next = head;
-		head = this;
+		for (size_t probe = 0; probe < TABLE_SIZE; probe++) {
+			auto *&slot = table[(hash + probe) % TABLE_SIZE];
+			if (slot == nullptr) {
+				slot = this;
+				return;
+			}
+
+			// Scripts couldn't tell the two apart, keep the first
+			if (slot->hash == hash) {
+#ifndef NDEBUG
+				__assert(__FILE__, __LINE__, "duplicate expression hash");
+#endif
+				return;
+			}
+		}
+
+		// Table is full, raise TABLE_SIZE
+#ifndef NDEBUG
+		__assert(__FILE__, __LINE__, "expression table full");
+#endif
+	}
+
+	// Look up the expression type with the given hash
+	static const expr_type *find(hash_t hash)
+	{
+		for (size_t probe = 0; probe < TABLE_SIZE; probe++) {
+			const auto *type = table[(hash + probe) % TABLE_SIZE];
+			if (type == nullptr || type->hash == hash)
+				return type;
+		}
+
+		return nullptr;
 	}
 };
 
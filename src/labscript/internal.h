@@ -1,5 +1,7 @@
 #pragma once
 
+#include "labscript/expression.h"
+
 namespace labscript {
 
 template<typename T>
@@ -12,4 +14,25 @@ inline bool set_result(void *result, T value)
 	return true;
 }
 
+// Evaluate an input through the result cache, checking it has the type the caller expects
+template<typename T>
+inline result evaluate_input(const expression *input, type expected, T *value)
+{
+	if (input == nullptr || input->get_type() != expected)
+		return result::wrong_type;
+
+	return input->evaluate(value);
+}
+
+// Evaluate every expression in a scope in order, stopping at the first error
+inline result evaluate_scope(const expression *first)
+{
+	for (const auto *expr = first; expr != nullptr; expr = expr->next) {
+		if (const auto error = expr->evaluate(nullptr); error != result::ok)
+			return error;
+	}
+
+	return result::ok;
+}
+
 } // namespace labscript
\ No newline at end of file
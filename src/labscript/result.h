@@ -4,7 +4,10 @@ namespace labscript {
 
 enum class result {
 	ok,
-	wrong_type
+	wrong_type,
+	bad_format,
+	unknown_expression,
+	out_of_memory
 };
 
 } // namespace labscript
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "dolphin/os.h"
+#include "dolphin/vi.h"
+#include "console/cvar.h"
+#include "input/poll.h"
+#include "match/events.h"
+#include "player/events.h"
+#include "labscript/internal.h"
+#include "labscript/scheduler.h"
+#include "labscript/script.h"
+#include "util/time.h"
+
+namespace labscript {
+
+// Maximum number of script/trigger pairs
+constexpr size_t MAX_BINDINGS = 32;
+// Maximum number of pending script runs
+constexpr size_t QUEUE_SIZE = 64;
+
+struct binding {
+	const labscript::script *script;
+	labscript::trigger trigger;
+};
+
+struct job {
+	const labscript::script *script;
+	labscript::context context;
+	size_t binding_index;
+};
+
+static binding bindings[MAX_BINDINGS];
+
+// Mask of SI channels with a queued input_poll run for each binding. Polls arrive several times
+// per frame per port, so a binding only ever has one run per channel waiting.
+static u8 polls_pending[MAX_BINDINGS];
+
+// Pending runs. Indices only ever increase, the queue is empty when they're equal.
+static job queue[QUEUE_SIZE];
+static size_t queue_read;
+static size_t queue_write;
+
+static context current_context;
+
+// Time spent running scripts during the current frame
+static u32 frame_retrace_count;
+static u32 frame_ticks_used;
+
+static console::cvar<int> budget("labscript_budget", {
+	.value = 1000, .min = 0, .max = 16000
+});
+
+const context &get_context()
+{
+	return current_context;
+}
+
+bool bind(const script *script, trigger trigger)
+{
+	// Bindings are read from the SI interrupt
+	const auto enabled = OSDisableInterrupts();
+	auto result = false;
+
+	for (auto &binding : bindings) {
+		if (binding.script == nullptr) {
+			binding = { script, trigger };
+			result = true;
+			break;
+		}
+	}
+
+	OSRestoreInterrupts(enabled);
+	return result;
+}
+
+void unbind(const script *script)
+{
+	const auto enabled = OSDisableInterrupts();
+
+	for (size_t i = 0; i < MAX_BINDINGS; i++) {
+		if (bindings[i].script == script) {
+			bindings[i] = { 0 };
+			polls_pending[i] = 0;
+		}
+	}
+
+	// Drop queued runs
+	auto write = queue_read;
+
+	for (auto read = queue_read; read != queue_write; read++) {
+		if (queue[read % QUEUE_SIZE].script != script)
+			queue[write++ % QUEUE_SIZE] = queue[read % QUEUE_SIZE];
+	}
+
+	queue_write = write;
+	OSRestoreInterrupts(enabled);
+}
+
+static bool push_job(const job &job)
+{
+	// May be called from the SI interrupt
+	const auto enabled = OSDisableInterrupts();
+
+	// Drop runs that don't fit rather than growing the backlog
+	const auto result = queue_write - queue_read < QUEUE_SIZE;
+
+	if (result)
+		queue[queue_write++ % QUEUE_SIZE] = job;
+
+	OSRestoreInterrupts(enabled);
+	return result;
+}
+
+static bool pop_job(job *job)
+{
+	const auto enabled = OSDisableInterrupts();
+	const auto result = queue_read != queue_write;
+
+	if (result) {
+		*job = queue[queue_read++ % QUEUE_SIZE];
+
+		if (job->context.trigger == trigger::input_poll)
+			polls_pending[job->binding_index] &= (u8)~(1 << job->context.chan);
+	}
+
+	OSRestoreInterrupts(enabled);
+	return result;
+}
+
+static void run_script(const script *script, const context &context)
+{
+	current_context = context;
+	evaluate_scope(script->get_root());
+}
+
+static void queue_triggered(const context &context)
+{
+	for (size_t i = 0; i < MAX_BINDINGS; i++) {
+		const auto &binding = bindings[i];
+
+		if (binding.script == nullptr || binding.trigger != context.trigger)
+			continue;
+
+		if (context.trigger != trigger::input_poll) {
+			push_job({ binding.script, context, i });
+			continue;
+		}
+
+		// Coalesce with the run already waiting for this channel
+		const auto mask = (u8)(1 << context.chan);
+
+		if (!(polls_pending[i] & mask) && push_job({ binding.script, context, i }))
+			polls_pending[i] |= mask;
+	}
+}
+
+static void run_queue()
+{
+	const auto retrace_count = VIGetRetraceCount();
+
+	if (retrace_count != frame_retrace_count) {
+		frame_retrace_count = retrace_count;
+		frame_ticks_used = 0;
+	}
+
+	// Scripts can't be preempted, so a run that starts under budget may end past it
+	const auto budget_ticks = us_to_ticks((u32)budget.get());
+	job job;
+
+	while (frame_ticks_used < budget_ticks && pop_job(&job)) {
+		const auto start = get_ticks();
+		run_script(job.script, job.context);
+		frame_ticks_used += get_ticks() - start;
+	}
+}
+
+} // namespace labscript
+
+EVENT_HANDLER(events::player::as_change, [](Player *player, u32 old_state, u32 new_state)
+{
+	labscript::queue_triggered({
+		.trigger   = labscript::trigger::as_change,
+		.player    = player,
+		.old_state = old_state,
+		.new_state = new_state
+	});
+
+	labscript::run_queue();
+});
+
+EVENT_HANDLER(events::player::think::input::pre, [](Player *player)
+{
+	labscript::queue_triggered({
+		.trigger   = labscript::trigger::think_pre,
+		.player    = player
+	});
+
+	labscript::run_queue();
+});
+
+EVENT_HANDLER(events::player::think::input::post, [](Player *player, u32 old_state, u32 new_state)
+{
+	labscript::queue_triggered({
+		.trigger   = labscript::trigger::think_post,
+		.player    = player,
+		.old_state = old_state,
+		.new_state = new_state
+	});
+
+	labscript::run_queue();
+});
+
+EVENT_HANDLER(events::input::deferred_poll, [](const poll_record &poll)
+{
+	// Polls are drained before PlayerThink_Input, run them with the other scripts there
+	labscript::queue_triggered({
+		.trigger   = labscript::trigger::input_poll,
+		.chan      = poll.chan
+	});
+});
+
+EVENT_HANDLER(events::match::exit, []()
+{
+	// Run exit scripts immediately since the queue is discarded with the match
+	for (const auto &binding : labscript::bindings) {
+		if (binding.script != nullptr && binding.trigger == labscript::trigger::match_exit)
+			labscript::run_script(binding.script, { .trigger = labscript::trigger::match_exit });
+	}
+
+	const auto enabled = OSDisableInterrupts();
+
+	for (auto &binding : labscript::bindings)
+		binding = { 0 };
+
+	for (auto &pending : labscript::polls_pending)
+		pending = 0;
+
+	labscript::queue_read = labscript::queue_write;
+	OSRestoreInterrupts(enabled);
+
+	labscript::script::unload_all();
+});
\ No newline at end of file
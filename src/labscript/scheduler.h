@@ -0,0 +1,39 @@
+#pragma once
+
+#include "melee/player.h"
+#include "labscript/script.h"
+#include <gctypes.h>
+
+namespace labscript {
+
+// Events a script can be bound to
+enum class trigger {
+	as_change,  // events::player::as_change
+	think_pre,  // events::player::think::input::pre
+	think_post, // events::player::think::input::post
+	input_poll, // events::input::deferred_poll
+	match_exit, // events::match::exit
+	count
+};
+
+// Arguments of the event that triggered the running script
+struct context {
+	labscript::trigger trigger;
+	// Null for input_poll and match_exit
+	Player *player;
+	u32 old_state;
+	u32 new_state;
+	// SI channel for input_poll
+	s32 chan;
+};
+
+// Context of the script being run by the scheduler
+const context &get_context();
+
+// Run a loaded script every time trigger fires. Returns false if out of bindings.
+bool bind(const script *script, trigger trigger);
+
+// Remove all bindings and queued runs of a script. Must be called before unloading it.
+void unbind(const script *script);
+
+} // namespace labscript
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "labscript/script.h"
+#include "labscript/serialize.h"
+
+namespace labscript {
+
+result script::load(const void *data, size_t size)
+{
+	unload();
+
+	size_t arena_size;
+	if (const auto error = measure_script(data, size, &arena_size); error != result::ok)
+		return error;
+
+	arena = labscript::arena(new u8[arena_size], arena_size);
+
+	// Link into list
+	prev = nullptr;
+	next = head;
+	if (head != nullptr)
+		head->prev = this;
+	head = this;
+
+	const auto error = decode_script(data, size, &arena, &root);
+	if (error != result::ok)
+		unload();
+
+	return error;
+}
+
+void script::unload()
+{
+	if (!is_loaded())
+		return;
+
+	// Unlink from list
+	if (prev != nullptr)
+		prev->next = next;
+	else
+		head = next;
+
+	if (next != nullptr)
+		next->prev = prev;
+
+	delete[] (u8*)arena.get_data();
+	arena = labscript::arena();
+	root = nullptr;
+}
+
+void script::unload_all()
+{
+	while (head != nullptr)
+		head->unload();
+}
+
+} // namespace labscript
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "labscript/arena.h"
+#include "labscript/expression.h"
+#include "labscript/result.h"
+
+namespace labscript {
+
+// A decoded script. All nodes live in one allocation that is released at once on unload.
+class script {
+	// Intrusive list of loaded scripts
+	inline static script *head;
+	script *prev;
+	script *next;
+
+	labscript::arena arena;
+	expression *root = nullptr;
+
+public:
+	script() = default;
+	script(const script&) = delete;
+	script &operator=(const script&) = delete;
+
+	~script()
+	{
+		unload();
+	}
+
+	bool is_loaded() const
+	{
+		return arena.get_data() != nullptr;
+	}
+
+	const expression *get_root() const
+	{
+		return root;
+	}
+
+	size_t get_memory_size() const
+	{
+		return arena.get_size();
+	}
+
+	// Decode a serialized script, replacing any script already loaded
+	result load(const void *data, size_t size);
+
+	// Free the script's nodes
+	void unload();
+
+	// Unload every loaded script
+	static void unload_all();
+};
+
+} // namespace labscript
\ No newline at end of file
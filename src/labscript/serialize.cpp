@@ -0,0 +1,172 @@
+#include "labscript/expression.h"
+#include "labscript/serialize.h"
+
+namespace labscript {
+
+static size_t count_nodes(const expression *expr)
+{
+	size_t count = 0;
+
+	for (; expr != nullptr; expr = expr->next)
+		count += 1 + count_nodes(expr->input) + count_nodes(expr->child);
+
+	return count;
+}
+
+static void encode_chain(const expression *expr, writer *writer)
+{
+	for (; expr != nullptr; expr = expr->next) {
+		const auto payload_size = expr->get_payload_size();
+		auto flags = (u8)(payload_size << node_flags::payload_shift);
+
+		if (expr->input != nullptr)
+			flags |= node_flags::has_input;
+		if (expr->child != nullptr)
+			flags |= node_flags::has_child;
+		if (expr->next != nullptr)
+			flags |= node_flags::has_next;
+
+		writer->write(expr->get_hash());
+		writer->write(flags);
+		expr->encode(writer);
+		encode_chain(expr->input, writer);
+		encode_chain(expr->child, writer);
+	}
+}
+
+static result decode_chain(reader *reader, arena *arena, size_t depth, size_t *node_count,
+                           expression **out)
+{
+	if (depth > MAX_DEPTH)
+		return result::bad_format;
+
+	while (true) {
+		hash_t hash;
+		u8 flags;
+
+		if (!reader->read(&hash) || !reader->read(&flags))
+			return result::bad_format;
+
+		const auto *type = expr_type::find(hash);
+		if (type == nullptr)
+			return result::unknown_expression;
+
+		auto *memory = arena->allocate(type->size, type->alignment);
+		if (memory == nullptr)
+			return result::out_of_memory;
+
+		auto *expr = type->constructor(memory);
+		expr->next = expr->child = expr->input = nullptr;
+		*out = expr;
+		(*node_count)++;
+
+		const auto payload_size = (size_t)(flags >> node_flags::payload_shift);
+		if (payload_size != expr->get_payload_size() || payload_size > reader->remaining())
+			return result::bad_format;
+
+		if (const auto error = expr->decode(reader); error != result::ok)
+			return error;
+
+		if (flags & node_flags::has_input) {
+			const auto error = decode_chain(reader, arena, depth + 1, node_count, &expr->input);
+			if (error != result::ok)
+				return error;
+		}
+
+		if (flags & node_flags::has_child) {
+			if (!expr->has_child())
+				return result::bad_format;
+
+			const auto error = decode_chain(reader, arena, depth + 1, node_count, &expr->child);
+			if (error != result::ok)
+				return error;
+		}
+
+		if (!(flags & node_flags::has_next))
+			return result::ok;
+
+		out = &expr->next;
+	}
+}
+
+size_t encode_script(const expression *root, void *buffer, size_t size)
+{
+	auto writer = labscript::writer(buffer, buffer != nullptr ? size : 0);
+
+	writer.write(script_header {
+		.magic      = SCRIPT_MAGIC,
+		.version    = SCRIPT_VERSION,
+		.node_count = (u16)count_nodes(root)
+	});
+
+	encode_chain(root, &writer);
+	return writer.written();
+}
+
+static result read_header(reader *reader, script_header *header)
+{
+	if (!reader->read(header))
+		return result::bad_format;
+
+	if (header->magic != SCRIPT_MAGIC || header->version != SCRIPT_VERSION)
+		return result::bad_format;
+
+	return result::ok;
+}
+
+result measure_script(const void *data, size_t size, size_t *arena_size)
+{
+	auto reader = labscript::reader(data, size);
+	*arena_size = 0;
+
+	script_header header;
+	if (const auto error = read_header(&reader, &header); error != result::ok)
+		return error;
+
+	// Nodes are stored flat in pre-order, so they can be walked without following links
+	for (auto i = 0; i < header.node_count; i++) {
+		hash_t hash;
+		u8 flags;
+
+		if (!reader.read(&hash) || !reader.read(&flags))
+			return result::bad_format;
+
+		const auto *type = expr_type::find(hash);
+		if (type == nullptr)
+			return result::unknown_expression;
+
+		if (!reader.skip(flags >> node_flags::payload_shift))
+			return result::bad_format;
+
+		*arena_size = arena::grow(*arena_size, type->size, type->alignment);
+	}
+
+	return result::ok;
+}
+
+result decode_script(const void *data, size_t size, arena *arena, expression **root)
+{
+	auto reader = labscript::reader(data, size);
+	*root = nullptr;
+
+	script_header header;
+	if (const auto error = read_header(&reader, &header); error != result::ok)
+		return error;
+
+	if (header.node_count == 0)
+		return reader.remaining() == 0 ? result::ok : result::bad_format;
+
+	size_t node_count = 0;
+	auto error = decode_chain(&reader, arena, 0, &node_count, root);
+
+	// Every byte must belong to one of the nodes the header counts
+	if (error == result::ok && (node_count != header.node_count || reader.remaining() != 0))
+		error = result::bad_format;
+
+	if (error != result::ok)
+		*root = nullptr;
+
+	return error;
+}
+
+} // namespace labscript
\ No newline at end of file
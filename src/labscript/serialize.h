@@ -0,0 +1,165 @@
+#pragma once
+
+#include "labscript/arena.h"
+#include "labscript/expression.h"
+#include "labscript/result.h"
+#include <bit>
+#include <cstring>
+#include <gctypes.h>
+#include <type_traits>
+
+namespace labscript {
+
+// Binary script format:
+//
+//   header   u32 magic, u16 version, u16 node count
+//   node     u32 hash, u8 flags, payload
+//
+// Nodes are stored in pre-order. Each node is followed by its input chain, then its child chain,
+// then the next node in its own scope. Multi-byte values are big-endian like the console, so
+// scripts encoded by host tools load unchanged.
+constexpr u32 SCRIPT_MAGIC   = 'LSCR';
+constexpr u16 SCRIPT_VERSION = 1;
+
+namespace node_flags {
+constexpr u8 has_input     = 1 << 0;
+constexpr u8 has_child     = 1 << 1;
+constexpr u8 has_next      = 1 << 2;
+constexpr u8 payload_shift = 3;
+} // node_flags
+
+// Largest payload that fits in the node flags
+constexpr size_t MAX_PAYLOAD_SIZE = 0xFF >> node_flags::payload_shift;
+
+// Deepest nesting of input and child chains, bounds the decoder's recursion
+constexpr size_t MAX_DEPTH = 32;
+
+struct script_header {
+	u32 magic;
+	u16 version;
+	u16 node_count;
+};
+
+// Convert a value between native and script byte order
+template<typename T>
+constexpr T swap_script_order(T value)
+{
+	static_assert(std::is_arithmetic_v<T>);
+
+	if constexpr (std::endian::native == std::endian::big || sizeof(T) == 1) {
+		return value;
+	} else {
+		using bits = std::conditional_t<sizeof(T) == 2, u16,
+		             std::conditional_t<sizeof(T) == 4, u32, u64>>;
+		return std::bit_cast<T>(std::byteswap(std::bit_cast<bits>(value)));
+	}
+}
+
+class reader {
+	const u8 *data;
+	size_t size;
+	size_t offset = 0;
+
+public:
+	reader(const void *data, size_t size) : data((const u8*)data), size(size)
+	{
+	}
+
+	size_t remaining() const
+	{
+		return size - offset;
+	}
+
+	bool read(void *out, size_t count)
+	{
+		if (count > remaining())
+			return false;
+
+		memcpy(out, &data[offset], count);
+		offset += count;
+		return true;
+	}
+
+	template<typename T>
+	bool read(T *out)
+	{
+		if (!read((void*)out, sizeof(T)))
+			return false;
+
+		*out = swap_script_order(*out);
+		return true;
+	}
+
+	bool read(script_header *out)
+	{
+		return read(&out->magic) && read(&out->version) && read(&out->node_count);
+	}
+
+	bool skip(size_t count)
+	{
+		if (count > remaining())
+			return false;
+
+		offset += count;
+		return true;
+	}
+};
+
+class writer {
+	u8 *data;
+	size_t size;
+	size_t offset = 0;
+	bool overflow = false;
+
+public:
+	writer(void *data, size_t size) : data((u8*)data), size(size)
+	{
+	}
+
+	// Number of bytes written, or that would have been written on overflow
+	size_t written() const
+	{
+		return offset;
+	}
+
+	bool overflowed() const
+	{
+		return overflow;
+	}
+
+	void write(const void *in, size_t count)
+	{
+		if (!overflow && count <= size - offset)
+			memcpy(&data[offset], in, count);
+		else
+			overflow = true;
+
+		offset += count;
+	}
+
+	template<typename T>
+	void write(const T &value)
+	{
+		const auto swapped = swap_script_order(value);
+		write((const void*)&swapped, sizeof(T));
+	}
+
+	void write(const script_header &header)
+	{
+		write(header.magic);
+		write(header.version);
+		write(header.node_count);
+	}
+};
+
+// Encode the scope chain starting at root. Pass a null buffer to only measure the size.
+// Returns the number of bytes required.
+size_t encode_script(const expression *root, void *buffer, size_t size);
+
+// Validate a script and find the arena size needed to decode it.
+result measure_script(const void *data, size_t size, size_t *arena_size);
+
+// Decode a script into an arena of at least the size returned by measure_script.
+result decode_script(const void *data, size_t size, arena *arena, expression **root);
+
+} // namespace labscript
\ No newline at end of file
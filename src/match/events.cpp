@@ -1,9 +1,24 @@
 #include "melee/match.h"
 #include "match/events.h"
+#include "player/events.h"
 #include "util/hooks.h"
 
+static bool in_match;
+
+// Players only think during matches, so the first one to think after an exit starts a new match
+HOOK_CHAIN(PlayerThink_Input, -3, [&](HSD_GObj *gobj)
+{
+	if (!in_match) {
+		in_match = true;
+		events::match::enter.fire();
+	}
+
+	original(gobj);
+});
+
 HOOK(Match_Exit, [&](MatchExitData *data)
 {
+	in_match = false;
 	events::match::exit.fire();
 	original(data);
 });
\ No newline at end of file
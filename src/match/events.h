@@ -3,5 +3,7 @@
 #include "event/event.h"
 
 namespace events::match {
+// Fired before the first player thinks in a match
+inline event<void()> enter;
 inline event<void()> exit;
 } // events::match
\ No newline at end of file
@@ -3,16 +3,18 @@
 #include "player/extra_player_data.h"
 #include "util/hooks.h"
 
-extern "C" void PlayerThink_Input(HSD_GObj *gobj);
-
 struct event_player_data {
 	s32 new_state;
 };
 
 static extra_player_data<event_player_data> player_data;
 
-HOOK(Player_ASChange, [&](HSD_GObj *gobj, u32 new_state, u32 flags, HSD_GObj *parent,
-                          f32 start_frame, f32 frame_rate, f32 lerp_override)
+// Other modules can hook these with HOOK_CHAIN, priorities below 0 run outside the events
+HOOK_CHAIN_ENTRY(Player_ASChange);
+HOOK_CHAIN_ENTRY(PlayerThink_Input);
+
+HOOK_CHAIN(Player_ASChange, 0, [&](HSD_GObj *gobj, u32 new_state, u32 flags, HSD_GObj *parent,
+                                   f32 start_frame, f32 frame_rate, f32 lerp_override)
 {
 	auto *player = gobj->get<Player>();
 	const auto old_state = player->action_state;
@@ -22,7 +24,7 @@ HOOK(Player_ASChange, [&](HSD_GObj *gobj, u32 new_state, u32 flags, HSD_GObj *pa
 	events::player::as_change.fire(player, old_state, new_state);
 });
 
-HOOK(PlayerThink_Input, [&](HSD_GObj *gobj)
+HOOK_CHAIN(PlayerThink_Input, 0, [&](HSD_GObj *gobj)
 {
 	auto *player = gobj->get<Player>();
 	const auto *data = player_data.get(player);
@@ -4,6 +4,8 @@
 #include "event/event.h"
 #include <gctypes.h>
 
+extern "C" void PlayerThink_Input(HSD_GObj *gobj);
+
 namespace events::player {
 inline event<void(Player *player, u32 old_state, u32 new_state)> as_change;
 } // events::player
@@ -1,7 +1,48 @@
+#include "console/console.h"
 #include "match/events.h"
 #include "player/extra_player_data.h"
+#include "util/hash.h"
+
+void extra_player_data_base::reset_all()
+{
+	for (auto *instance = head; instance != nullptr; instance = instance->next)
+		instance->reset();
+}
+
+size_t extra_player_data_base::get_count()
+{
+	size_t count = 0;
+
+	for (auto *instance = head; instance != nullptr; instance = instance->next)
+		count++;
+
+	return count;
+}
+
+size_t extra_player_data_base::get_total_size()
+{
+	size_t size = 0;
+
+	for (auto *instance = head; instance != nullptr; instance = instance->next)
+		size += instance->get_size();
+
+	return size;
+}
 
 EVENT_HANDLER(events::match::exit, []()
 {
-	extra_player_data_detail::match_number++;
+	// Reset here so get() doesn't need to check for a new match
+	extra_player_data_base::reset_all();
+});
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	if (cmd_hash != hash<"player_data_size">())
+		return false;
+
+	console::printf("%u player data instances, %u bytes",
+	                (u32)extra_player_data_base::get_count(),
+	                (u32)extra_player_data_base::get_total_size());
+
+	return true;
 });
\ No newline at end of file
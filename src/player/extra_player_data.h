@@ -1,33 +1,75 @@
 #pragma once
 
 #include "melee/player.h"
+#include "savestate/savestate.h"
+#include <cstddef>
+#include <new>
 
-namespace extra_player_data_detail {
-inline size_t match_number;
-} // extra_player_data_detail
+// Per-player side data. Every instance is reset together on match exit and included in
+// savestates.
+class extra_player_data_base : public savestate::region_source {
+	inline static extra_player_data_base *head;
+	extra_player_data_base *next;
+
+protected:
+	// One entry per player slot and secondary character
+	static constexpr size_t ENTRY_COUNT = 12;
+
+	extra_player_data_base()
+	{
+		// Link into list
+		next = head;
+		head = this;
+	}
+
+	static size_t get_index(const Player *player)
+	{
+		return player->slot * 2 + player->is_secondary_char;
+	}
+
+public:
+	virtual void reset() = 0;
+	virtual void *get_data() = 0;
+	virtual size_t get_size() const = 0;
+
+	void collect(savestate::region_list *list) const override
+	{
+		list->add(const_cast<extra_player_data_base*>(this)->get_data(), get_size());
+	}
+
+	static void reset_all();
+	static size_t get_count();
+	static size_t get_total_size();
+};
 
 template<typename T>
-class extra_player_data {
-	mutable T data[12];
-	mutable size_t match_number;
+class extra_player_data : public extra_player_data_base {
+	T data[ENTRY_COUNT];
 
 public:
 	const T *get(const Player *player) const
 	{
-		if (match_number != extra_player_data_detail::match_number) {
-			// New match started, reset data
-			for (auto &elem : data)
-				new (&elem) T;
+		return &data[get_index(player)];
+	}
 
-			match_number = extra_player_data_detail::match_number;
-		}
+	T *get(const Player *player)
+	{
+		return &data[get_index(player)];
+	}
 
-		return &data[player->slot * 2 + player->is_secondary_char];
+	void reset() override
+	{
+		for (auto &elem : data)
+			new (&elem) T;
 	}
 
-	T *get(const Player *player)
+	void *get_data() override
 	{
-		return const_cast<T*>(const_cast<const extra_player_data&>(*this).get(player));
+		return data;
 	}
 
+	size_t get_size() const override
+	{
+		return sizeof(data);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "render/events.h"
+#include "render/overlay.h"
+#include "util/hooks.h"
+
+extern "C" void GObj_RenderAll();
+
+HOOK(GObj_RenderAll, [&]()
+{
+	original();
+
+	// Draw overlays in one pass under ImGui, each in its own layer so overlays don't interleave
+	for (const auto *handler = events::render::overlay.head; handler != nullptr;
+	     handler = handler->next) {
+		handler->handle();
+		overlay::end_layer();
+	}
+
+	overlay::flush();
+
+	events::render::post.fire();
+});
\ No newline at end of file
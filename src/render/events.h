@@ -0,0 +1,11 @@
+#pragma once
+
+#include "event/event.h"
+
+namespace events::render {
+// Fired once per frame after the game finishes rendering, to add overlay primitives. Each
+// handler draws in its own overlay layer.
+inline event<void()> overlay;
+// Fired once per frame after overlays are drawn
+inline event<void()> post;
+} // events::render
\ No newline at end of file
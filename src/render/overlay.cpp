@@ -0,0 +1,220 @@
+#include "dolphin/gx.h"
+#include "render/overlay.h"
+#include "util/draw/render.h"
+#include "util/vector.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <gctypes.h>
+#include <numbers>
+#include <ogc/gx.h>
+
+namespace overlay {
+
+// Runs of vertices with the same render state
+constexpr size_t MAX_COMMANDS = 256;
+
+struct vertex {
+	float x, y;
+	u32 color;
+};
+
+// Primitive type in the high byte, GX line width in the low byte
+using state_key = u16;
+
+struct command {
+	state_key key;
+	u16 first;
+	u16 count;
+};
+
+static vertex vertices[MAX_VERTICES];
+static size_t vertex_count;
+
+static command commands[MAX_COMMANDS];
+static size_t command_count;
+// First command of the layer being added to
+static size_t layer_start;
+
+static const auto unit_circle = [] {
+	std::array<vec2, CIRCLE_SEGMENTS + 1> points;
+
+	for (size_t i = 0; i <= CIRCLE_SEGMENTS; i++) {
+		const auto angle = (float)i * 2.f * std::numbers::pi_v<float> / CIRCLE_SEGMENTS;
+		points[i] = vec2(std::cos(angle), std::sin(angle));
+	}
+
+	return points;
+}();
+
+static state_key make_key(u8 primitive, float width = 0.f)
+{
+	// GX line widths are in sixths of a pixel
+	const auto gx_width = (u8)std::clamp(width * 6.f, 1.f, 255.f);
+	return (state_key)(primitive << 8 | (primitive == GX_LINES ? gx_width : 0));
+}
+
+// Reserve vertices, extending the latest command if the state didn't change
+static vertex *add_vertices(state_key key, size_t count)
+{
+	if (vertex_count + count > MAX_VERTICES)
+		return nullptr;
+
+	if (command_count != 0 && commands[command_count - 1].key == key) {
+		auto &last = commands[command_count - 1];
+		last.count = (u16)(last.count + count);
+	} else {
+		if (command_count == MAX_COMMANDS)
+			return nullptr;
+
+		commands[command_count++] = { key, (u16)vertex_count, (u16)count };
+	}
+
+	auto *out = &vertices[vertex_count];
+	vertex_count += count;
+	return out;
+}
+
+size_t get_free_vertices()
+{
+	return MAX_VERTICES - vertex_count;
+}
+
+void line(const vec2 &a, const vec2 &b, u32 color, float width)
+{
+	auto *out = add_vertices(make_key(GX_LINES, width), LINE_VERTICES);
+	if (out == nullptr)
+		return;
+
+	out[0] = { a.x, a.y, color };
+	out[1] = { b.x, b.y, color };
+}
+
+void rect(const vec2 &min, const vec2 &max, u32 color)
+{
+	auto *out = add_vertices(make_key(GX_TRIANGLES), RECT_VERTICES);
+	if (out == nullptr)
+		return;
+
+	out[0] = { min.x, min.y, color };
+	out[1] = { max.x, min.y, color };
+	out[2] = { max.x, max.y, color };
+	out[3] = { min.x, min.y, color };
+	out[4] = { max.x, max.y, color };
+	out[5] = { min.x, max.y, color };
+}
+
+void rect_outline(const vec2 &min, const vec2 &max, u32 color, float width)
+{
+	line(min, vec2(max.x, min.y), color, width);
+	line(vec2(max.x, min.y), max, color, width);
+	line(max, vec2(min.x, max.y), color, width);
+	line(vec2(min.x, max.y), min, color, width);
+}
+
+void circle(const vec2 &center, float radius, u32 color)
+{
+	auto *out = add_vertices(make_key(GX_TRIANGLES), CIRCLE_VERTICES);
+	if (out == nullptr)
+		return;
+
+	for (size_t i = 0; i < CIRCLE_SEGMENTS; i++) {
+		const auto &p0 = unit_circle[i];
+		const auto &p1 = unit_circle[i + 1];
+		*out++ = { center.x, center.y, color };
+		*out++ = { center.x + p0.x * radius, center.y + p0.y * radius, color };
+		*out++ = { center.x + p1.x * radius, center.y + p1.y * radius, color };
+	}
+}
+
+void circle_outline(const vec2 &center, float radius, u32 color, float width)
+{
+	auto *out = add_vertices(make_key(GX_LINES, width), CIRCLE_OUTLINE_VERTICES);
+	if (out == nullptr)
+		return;
+
+	for (size_t i = 0; i < CIRCLE_SEGMENTS; i++) {
+		const auto &p0 = unit_circle[i];
+		const auto &p1 = unit_circle[i + 1];
+		*out++ = { center.x + p0.x * radius, center.y + p0.y * radius, color };
+		*out++ = { center.x + p1.x * radius, center.y + p1.y * radius, color };
+	}
+}
+
+static void setup_render_state()
+{
+	// Set up transforms/scissor/fog
+	render_state::get().reset_2d();
+
+	// Untextured, color from vertices
+	GX_SetNumChans(1);
+	GX_SetChanCtrl(GX_COLOR0A0, GX_DISABLE, GX_SRC_REG, GX_SRC_VTX, GX_LIGHTNULL, GX_DF_NONE,
+	               GX_AF_NONE);
+	GX_SetNumTexGens(0);
+	GX_SetNumTevStages(1);
+	GX_SetTevOrder(GX_TEVSTAGE0, GX_TEXCOORDNULL, GX_TEXMAP_NULL, GX_COLOR0A0);
+	GX_SetTevOp(GX_TEVSTAGE0, GX_PASSCLR);
+
+	GX_SetZMode(GX_FALSE, GX_NEVER, GX_FALSE);
+	GX_SetCullMode(GX_CULL_NONE);
+
+	GX_ClearVtxDesc();
+	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_POS, GX_POS_XY, GX_F32, 0);
+	GX_SetVtxDesc(GX_VA_POS, GX_DIRECT);
+	GX_SetVtxAttrFmt(GX_VTXFMT0, GX_VA_CLR0, GX_CLR_RGBA, GX_RGBA8, 0);
+	GX_SetVtxDesc(GX_VA_CLR0, GX_DIRECT);
+}
+
+void end_layer()
+{
+	auto *begin = commands + layer_start;
+	auto *end = commands + command_count;
+
+	// Group by state, keeping submission order within each state
+	std::sort(begin, end, [](const command &a, const command &b) {
+		return a.key != b.key ? a.key < b.key : a.first < b.first;
+	});
+
+	layer_start = command_count;
+}
+
+void flush()
+{
+	end_layer();
+
+	if (command_count == 0)
+		return;
+
+	setup_render_state();
+
+	for (size_t i = 0; i < command_count;) {
+		const auto key = commands[i].key;
+		const auto primitive = (u8)(key >> 8);
+		size_t total = 0;
+		size_t end = i;
+
+		for (; end < command_count && commands[end].key == key; end++)
+			total += commands[end].count;
+
+		if (primitive == GX_LINES)
+			GX_SetLineWidth((u8)key, GX_TO_ZERO);
+
+		GX_Begin(primitive, GX_VTXFMT0, (u16)total);
+
+		for (; i < end; i++) {
+			const auto *vtx = &vertices[commands[i].first];
+
+			for (size_t j = 0; j < commands[i].count; j++, vtx++)
+				gx_fifo->write(vtx->x, vtx->y, vtx->color);
+		}
+	}
+
+	// Restore cull mode to expected value
+	GX_SetCullMode(GX_CULL_BACK);
+
+	vertex_count = 0;
+	command_count = 0;
+	layer_start = 0;
+}
+
+} // namespace overlay
\ No newline at end of file
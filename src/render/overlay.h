@@ -0,0 +1,38 @@
+#pragma once
+
+#include "util/vector.h"
+#include <cstddef>
+#include <gctypes.h>
+
+// Screen space primitives from all overlays, drawn in one pass after the game renders. Within a
+// layer, primitives are batched by render state, so only primitives that share a type and line
+// width keep their order. Layers draw in order. Coordinates match ImGui's and colors are RGBA.
+namespace overlay {
+
+// Vertices shared by all primitives in a frame, anything past this is dropped
+constexpr size_t MAX_VERTICES = 2048;
+constexpr size_t CIRCLE_SEGMENTS = 24;
+
+// Vertices each primitive takes from the frame's budget
+constexpr size_t LINE_VERTICES           = 2;
+constexpr size_t RECT_VERTICES           = 6;
+constexpr size_t CIRCLE_VERTICES         = CIRCLE_SEGMENTS * 3;
+constexpr size_t CIRCLE_OUTLINE_VERTICES = CIRCLE_SEGMENTS * 2;
+
+// Vertices left for primitives added before the next flush, for overlays that can trim detail
+size_t get_free_vertices();
+
+// Line widths are in pixels
+void line(const vec2 &a, const vec2 &b, u32 color, float width = 1.f);
+void rect(const vec2 &min, const vec2 &max, u32 color);
+void rect_outline(const vec2 &min, const vec2 &max, u32 color, float width = 1.f);
+void circle(const vec2 &center, float radius, u32 color);
+void circle_outline(const vec2 &center, float radius, u32 color, float width = 1.f);
+
+// Start a new layer, everything added so far draws under what comes next
+void end_layer();
+
+// Draw and clear everything added since the last flush
+void flush();
+
+} // namespace overlay
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "event/event.h"
+
+namespace events::savestate {
+// Fired after a savestate load or rewind writes old state back over the live regions
+inline event<void()> restore;
+} // events::savestate
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "dolphin/vi.h"
+#include "console/console.h"
+#include "console/cvar.h"
+#include "match/events.h"
+#include "player/events.h"
+#include "savestate/events.h"
+#include "savestate/savestate.h"
+#include "util/hash.h"
+#include "util/hooks.h"
+#include <cstdlib>
+#include <cstring>
+#include <gctypes.h>
+
+namespace savestate {
+
+// Frames of history, about 17 seconds
+constexpr size_t MAX_FRAMES = 1024;
+// Marks the end of the used part of the ring, the next run starts at offset 0
+constexpr u16 WRAP_REGION = 0xFFFF;
+
+// Bytes of the ring used by one frame, including any skipped at the end before wrapping
+struct frame_record {
+	u32 start;
+	u32 size;
+};
+
+// State at the start of the latest captured frame
+static region_list layout;
+static size_t shadow_offsets[MAX_REGIONS];
+static u8 *shadow;
+
+// Runs of the bytes each frame overwrote, oldest first
+static u8 *ring;
+static size_t ring_capacity;
+static size_t write_pos;
+static size_t used;
+
+static frame_record frames[MAX_FRAMES];
+static size_t oldest_frame;
+static size_t frame_count;
+
+// Size of the frame being captured
+static size_t capture_size;
+static u32 capture_retrace_count;
+
+static void free_history()
+{
+	delete[] shadow;
+	delete[] ring;
+	shadow = nullptr;
+	ring = nullptr;
+	ring_capacity = 0;
+	write_pos = 0;
+	used = 0;
+	frame_count = 0;
+}
+
+static console::cvar<int> rewind_kb("rewind_kb", {
+	.value = 0, .min = 0, .max = 1024,
+	.set = [](int value) {
+		free_history();
+	}});
+
+static void reset_history(const region_list &regions)
+{
+	free_history();
+
+	layout = regions;
+
+	size_t offset = 0;
+	for (size_t i = 0; i < layout.get_count(); i++) {
+		shadow_offsets[i] = offset;
+		offset += layout[i].size;
+	}
+
+	shadow = new u8[offset];
+	copy_regions(layout, shadow);
+
+	ring_capacity = (size_t)rewind_kb.get() * 1024;
+	ring = new u8[ring_capacity];
+}
+
+static void drop_oldest_frame()
+{
+	used -= frames[oldest_frame].size;
+	oldest_frame = (oldest_frame + 1) % MAX_FRAMES;
+	frame_count--;
+}
+
+// Get contiguous space for the frame being captured, dropping old frames to make room. Runs
+// never straddle the end of the ring, and positions that reach the end go back to 0.
+static u8 *reserve(size_t size)
+{
+	const auto wraps = ring_capacity - write_pos < size;
+	const auto skip = wraps ? ring_capacity - write_pos : 0;
+
+	while (used + skip + size > ring_capacity) {
+		// Never drop part of the frame being captured
+		if (frame_count == 0)
+			return nullptr;
+
+		drop_oldest_frame();
+	}
+
+	if (wraps) {
+		if (skip >= sizeof(delta_run)) {
+			const auto marker = delta_run { .region = WRAP_REGION };
+			memcpy(ring + write_pos, &marker, sizeof(marker));
+		}
+
+		write_pos = 0;
+	}
+
+	auto *out = ring + write_pos;
+	write_pos += size;
+	used += skip + size;
+	capture_size += skip + size;
+
+	if (write_pos == ring_capacity)
+		write_pos = 0;
+
+	return out;
+}
+
+// Save the bytes a run is about to lose and bring the shadow copy up to date
+static bool add_undo_run(size_t region, size_t offset, size_t size)
+{
+	auto *out = reserve(sizeof(delta_run) + size);
+	if (out == nullptr)
+		return false;
+
+	const auto run = delta_run {
+		.region = (u16)region,
+		.offset = (u32)offset,
+		.size   = (u32)size
+	};
+
+	auto *saved = shadow + shadow_offsets[region] + offset;
+	memcpy(out, &run, sizeof(run));
+	memcpy(out + sizeof(run), saved, size);
+	memcpy(saved, (const u8*)layout[region].address + offset, size);
+	return true;
+}
+
+static void capture()
+{
+	region_list regions;
+	region_source::collect_all(&regions);
+
+	if (ring == nullptr || !(regions == layout)) {
+		reset_history(regions);
+		return;
+	}
+
+	if (frame_count == MAX_FRAMES)
+		drop_oldest_frame();
+
+	const auto start = write_pos;
+	capture_size = 0;
+
+	if (!diff_regions(layout, shadow, add_undo_run)) {
+		// One frame changed more than the whole ring holds
+		reset_history(regions);
+		return;
+	}
+
+	frames[(oldest_frame + frame_count) % MAX_FRAMES] = { (u32)start, (u32)capture_size };
+	frame_count++;
+}
+
+// Apply a frame's undo runs to a copy of the regions laid out like the shadow copy
+static void undo_frame(const frame_record &frame, u8 *state)
+{
+	auto pos = (size_t)frame.start;
+
+	for (size_t left = frame.size; left != 0;) {
+		delta_run run;
+
+		if (ring_capacity - pos >= sizeof(run))
+			memcpy(&run, ring + pos, sizeof(run));
+
+		// Same rule as reserve, skip to the start when a run doesn't fit before the end
+		if (ring_capacity - pos < sizeof(run) || run.region == WRAP_REGION) {
+			left -= ring_capacity - pos;
+			pos = 0;
+			continue;
+		}
+
+		const auto *data = ring + pos + sizeof(run);
+		memcpy(state + shadow_offsets[run.region] + run.offset, data, run.size);
+		pos += sizeof(run) + run.size;
+		left -= sizeof(run) + run.size;
+
+		if (pos == ring_capacity)
+			pos = 0;
+	}
+}
+
+static const frame_record &get_newest_frame(size_t skip = 0)
+{
+	return frames[(oldest_frame + frame_count - 1 - skip) % MAX_FRAMES];
+}
+
+static void rewind(int count)
+{
+	region_list regions;
+	region_source::collect_all(&regions);
+
+	if (ring == nullptr || !(regions == layout)) {
+		console::print("No rewind history for the current match.");
+		return;
+	}
+
+	// Undo frames in a copy so the result can be checked before anything is overwritten. Starting
+	// from the shadow copy discards whatever happened since the latest frame started.
+	const auto state_size = layout.get_total_size();
+	auto *state = new u8[state_size];
+	memcpy(state, shadow, state_size);
+
+	size_t undone = 0;
+	for (; undone < (size_t)count && undone < frame_count; undone++)
+		undo_frame(get_newest_frame(undone), state);
+
+	if (!pointers_match(layout, state)) {
+		console::print("Can't rewind, players reference different objects than back then.");
+		delete[] state;
+		return;
+	}
+
+	restore_regions(layout, state);
+	memcpy(shadow, state, state_size);
+	delete[] state;
+	events::savestate::restore.fire();
+
+	// Forget the undone frames, the next capture overwrites them
+	for (size_t i = 0; i < undone; i++) {
+		write_pos = get_newest_frame().start;
+		used -= get_newest_frame().size;
+		frame_count--;
+	}
+
+	console::printf("Rewound %u frames, %u left in %u bytes", (u32)undone, (u32)frame_count,
+	                (u32)used);
+}
+
+// Called for each player, only capture on the first one of a frame
+static void capture_frame()
+{
+	if (rewind_kb.get() == 0 || VIGetRetraceCount() == capture_retrace_count)
+		return;
+
+	capture_retrace_count = VIGetRetraceCount();
+	capture();
+}
+
+} // namespace savestate
+
+// Capture before anything else touches the frame
+HOOK_CHAIN(PlayerThink_Input, -2, [&](HSD_GObj *gobj)
+{
+	savestate::capture_frame();
+	original(gobj);
+});
+
+EVENT_HANDLER(events::match::exit, []()
+{
+	savestate::free_history();
+});
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	if (cmd_hash != hash<"rewind">())
+		return false;
+
+	const auto count = argc >= 2 ? strtol(argv[1], nullptr, 0) : 1;
+
+	if (count < 1) {
+		console::print("Expected a positive number of frames.");
+		return true;
+	}
+
+	savestate::rewind((int)count);
+	return true;
+});
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "melee/player.h"
+#include "console/console.h"
+#include "match/events.h"
+#include "savestate/events.h"
+#include "savestate/savestate.h"
+#include "util/hash.h"
+#include "util/time.h"
+#include <cstring>
+#include <gctypes.h>
+
+namespace savestate {
+
+// Rebase with a full snapshot when a delta would be larger than 1/n of it
+constexpr size_t MAX_DELTA_FRACTION = 2;
+
+// Buffers are kept across saves and matches and only reallocated to grow, so saving and loading
+// during a match doesn't churn the heap
+
+// Regions and full copy of the last full snapshot, no snapshot if base_size is 0
+static region_list layout;
+static u8 *base;
+static size_t base_capacity;
+static size_t base_size;
+
+// Runs that differ from the base snapshot in the latest save
+static u8 *delta;
+static size_t delta_capacity;
+static size_t delta_size;
+
+// Where load rebuilds the saved state before checking it
+static u8 *scratch;
+static size_t scratch_capacity;
+
+void region_source::collect_all(region_list *list)
+{
+	for (const auto *source = head; source != nullptr; source = source->next)
+		source->collect(list);
+}
+
+// Players only exist during a match, so look them up at save time. They point at items, JObjs
+// and other players' GObjs, none of which are captured.
+static dynamic_regions players([](region_list *list) {
+	for (auto i = 0; i < 6; i++) {
+		if (auto *gobj = PlayerBlock_GetGObj(i); gobj != nullptr)
+			list->add(gobj->get<Player>(), sizeof(Player), true);
+	}
+});
+
+static bool matches_layout(const region_list &regions)
+{
+	return base_size != 0 && regions == layout;
+}
+
+static void discard_snapshot()
+{
+	base_size = 0;
+	delta_size = 0;
+}
+
+// Make a buffer hold at least size bytes, keeping it if it already does
+static void reserve(u8 **buffer, size_t *capacity, size_t size)
+{
+	if (size <= *capacity)
+		return;
+
+	delete[] *buffer;
+	*buffer = new u8[size];
+	*capacity = size;
+}
+
+static void save_full(const region_list &regions)
+{
+	discard_snapshot();
+
+	layout = regions;
+	const auto size = regions.get_total_size();
+	reserve(&base, &base_capacity, size);
+	reserve(&delta, &delta_capacity, size / MAX_DELTA_FRACTION);
+	reserve(&scratch, &scratch_capacity, size);
+	base_size = size;
+
+	copy_regions(layout, base);
+}
+
+static bool add_run(size_t region, size_t offset, size_t size)
+{
+	const auto *data = (const u8*)layout[region].address + offset;
+
+	if (delta_size + sizeof(delta_run) + size > base_size / MAX_DELTA_FRACTION)
+		return false;
+
+	const auto run = delta_run {
+		.region = (u16)region,
+		.offset = (u32)offset,
+		.size   = (u32)size
+	};
+
+	memcpy(delta + delta_size, &run, sizeof(run));
+	memcpy(delta + delta_size + sizeof(run), data, size);
+	delta_size += sizeof(run) + size;
+	return true;
+}
+
+// Store the blocks that changed since the base snapshot. Returns false if the delta doesn't fit.
+static bool save_delta()
+{
+	delta_size = 0;
+	return diff_regions(layout, base, add_run);
+}
+
+static void save()
+{
+	const auto start = get_time();
+
+	region_list regions;
+	region_source::collect_all(&regions);
+
+	const auto full = !matches_layout(regions) || !save_delta();
+	if (full)
+		save_full(regions);
+
+	console::printf("Saved %u regions, %u byte %s in %uus",
+	                (u32)layout.get_count(), (u32)(full ? base_size : delta_size),
+	                full ? "snapshot" : "delta", ticks_to_us(get_time() - start));
+}
+
+static void load()
+{
+	const auto start = get_time();
+
+	region_list regions;
+	region_source::collect_all(&regions);
+
+	if (!matches_layout(regions)) {
+		console::print("No savestate for the current match.");
+		return;
+	}
+
+	// Rebuild the saved state aside so it can be checked before anything is overwritten
+	auto *state = scratch;
+	memcpy(state, base, base_size);
+
+	for (size_t offset = 0; offset < delta_size;) {
+		delta_run run;
+		memcpy(&run, delta + offset, sizeof(run));
+		offset += sizeof(run);
+
+		memcpy(state + layout.get_offset(run.region) + run.offset, delta + offset, run.size);
+		offset += run.size;
+	}
+
+	if (!pointers_match(layout, state)) {
+		console::print("Can't load, players reference different objects than when saved.");
+		return;
+	}
+
+	restore_regions(layout, state);
+	events::savestate::restore.fire();
+
+	console::printf("Loaded savestate in %uus", ticks_to_us(get_time() - start));
+}
+
+} // namespace savestate
+
+EVENT_HANDLER(events::match::exit, []()
+{
+	// Player memory is freed with the match
+	savestate::discard_snapshot();
+});
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	switch (cmd_hash) {
+	case hash<"savestate_save">():
+		savestate::save();
+		return true;
+	case hash<"savestate_load">():
+		savestate::load();
+		return true;
+	default:
+		return false;
+	}
+});
\ No newline at end of file
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <gctypes.h>
+
+namespace savestate {
+
+// Maximum number of memory regions in a snapshot
+constexpr size_t MAX_REGIONS = 64;
+// Granularity of deltas, one cache line
+constexpr size_t BLOCK_SIZE = 32;
+// Cached main RAM, where any pointer to a game object points
+constexpr u32 MEM1_START = 0x80000000;
+constexpr u32 MEM1_END   = 0x81800000;
+
+struct region {
+	void *address;
+	size_t size;
+	// Whether the region points at objects outside the snapshot that may be freed or reused,
+	// e.g. items and JObjs from a Player. Restores that would change those pointers are refused.
+	bool guard_pointers;
+};
+
+// Changed bytes of one region, followed by the data
+struct delta_run {
+	u16 region;
+	u16 pad;
+	u32 offset;
+	u32 size;
+};
+
+class region_list {
+	region regions[MAX_REGIONS];
+	size_t count = 0;
+
+public:
+	bool add(void *address, size_t size, bool guard_pointers = false)
+	{
+		if (count >= MAX_REGIONS)
+			return false;
+
+		regions[count++] = { address, size, guard_pointers };
+		return true;
+	}
+
+	size_t get_count() const
+	{
+		return count;
+	}
+
+	const region &operator[](size_t index) const
+	{
+		return regions[index];
+	}
+
+	// Offset of a region when the list is copied back to back
+	size_t get_offset(size_t index) const
+	{
+		size_t offset = 0;
+
+		for (size_t i = 0; i < index; i++)
+			offset += regions[i].size;
+
+		return offset;
+	}
+
+	size_t get_total_size() const
+	{
+		size_t size = 0;
+
+		for (size_t i = 0; i < count; i++)
+			size += regions[i].size;
+
+		return size;
+	}
+
+	bool operator==(const region_list &other) const
+	{
+		if (count != other.count)
+			return false;
+
+		for (size_t i = 0; i < count; i++) {
+			if (regions[i].address        != other.regions[i].address ||
+			    regions[i].size           != other.regions[i].size    ||
+			    regions[i].guard_pointers != other.regions[i].guard_pointers)
+				return false;
+		}
+
+		return true;
+	}
+};
+
+// Call on_run(region, offset, size) for each run of blocks that differ between the regions and
+// a saved copy of them laid out back to back. Stops and returns false if on_run does.
+bool diff_regions(const region_list &regions, const u8 *saved, auto &&on_run)
+{
+	for (size_t i = 0; i < regions.get_count(); i++) {
+		const auto *current = (const u8*)regions[i].address;
+		const auto size = regions[i].size;
+		size_t run_start = 0;
+		size_t run_size = 0;
+
+		for (size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+			const auto block = std::min(BLOCK_SIZE, size - offset);
+
+			if (memcmp(current + offset, saved + offset, block) != 0) {
+				if (run_size == 0)
+					run_start = offset;
+
+				run_size += block;
+				continue;
+			}
+
+			if (run_size != 0 && !on_run(i, run_start, run_size))
+				return false;
+
+			run_size = 0;
+		}
+
+		if (run_size != 0 && !on_run(i, run_start, run_size))
+			return false;
+
+		saved += size;
+	}
+
+	return true;
+}
+
+// Copy regions back to back into a buffer of get_total_size() bytes
+inline void copy_regions(const region_list &regions, u8 *out)
+{
+	for (size_t i = 0; i < regions.get_count(); i++) {
+		memcpy(out, regions[i].address, regions[i].size);
+		out += regions[i].size;
+	}
+}
+
+// Inverse of copy_regions
+inline void restore_regions(const region_list &regions, const u8 *in)
+{
+	for (size_t i = 0; i < regions.get_count(); i++) {
+		memcpy(regions[i].address, in, regions[i].size);
+		in += regions[i].size;
+	}
+}
+
+inline bool is_mem1_pointer(u32 value)
+{
+	return value >= MEM1_START && value < MEM1_END;
+}
+
+// Whether restoring a saved copy made by copy_regions would leave every pointer in guarded
+// regions as it is now. Objects those pointers reference aren't part of the snapshot, so a
+// pointer that changed may refer to one that has been freed or reused since.
+inline bool pointers_match(const region_list &regions, const u8 *saved)
+{
+	for (size_t i = 0; i < regions.get_count(); i++) {
+		const auto *current = (const u8*)regions[i].address;
+		const auto size = regions[i].size;
+
+		for (size_t offset = 0; regions[i].guard_pointers && offset + 4 <= size; offset += 4) {
+			u32 saved_value, current_value;
+			memcpy(&saved_value, saved + offset, 4);
+			memcpy(&current_value, current + offset, 4);
+
+			if (saved_value == current_value)
+				continue;
+
+			if (is_mem1_pointer(saved_value) || is_mem1_pointer(current_value))
+				return false;
+		}
+
+		saved += size;
+	}
+
+	return true;
+}
+
+// Something that contributes memory to snapshots
+class region_source {
+	inline static region_source *head;
+	region_source *next;
+
+protected:
+	region_source()
+	{
+		// Link into list
+		next = head;
+		head = this;
+	}
+
+public:
+	virtual void collect(region_list *list) const = 0;
+
+	static void collect_all(region_list *list);
+};
+
+// A fixed block of memory, e.g. a static buffer
+class static_region : public region_source {
+	void *address;
+	size_t size;
+
+public:
+	static_region(void *address, size_t size) : address(address), size(size)
+	{
+	}
+
+	void collect(region_list *list) const override
+	{
+		list->add(address, size);
+	}
+};
+
+// Memory that only exists at times, e.g. player data, added by a callback
+class dynamic_regions : public region_source {
+	void(*callback)(region_list *list);
+
+public:
+	dynamic_regions(void(*callback)(region_list *list)) : callback(callback)
+	{
+	}
+
+	void collect(region_list *list) const override
+	{
+		callback(list);
+	}
+};
+
+} // namespace savestate
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "util/meta.h"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <string_view>
 
 using hash_t = unsigned int;
 
@@ -44,4 +48,100 @@ inline hash_t hash(const char *str)
 		hash = (hash ^ c) * fnv1a::prime;
 
 	return hash;
-}
\ No newline at end of file
+}
+
+// Runtime FNV1a hash of a string that isn't null terminated
+constexpr hash_t hash(const char *str, size_t length)
+{
+	auto hash = fnv1a::offset_basis;
+
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ str[i]) * fnv1a::prime;
+
+	return hash;
+}
+
+// Map from string keys to values built at compile time. Each key gets its own slot in a power of
+// two table, so a lookup is one hash, one index and one compare, plus a string compare when looking
+// up by name.
+template<typename T, string_literal ...keys>
+class static_map {
+	static constexpr size_t count = sizeof...(keys);
+	static constexpr size_t MAX_TABLE_SIZE = 1024;
+
+	static_assert(count > 0 && count < 256);
+
+	static constexpr hash_t hashes[] = { hash<keys>()... };
+	static constexpr std::string_view names[] = { std::string_view(keys.value, keys.size)... };
+
+	static consteval bool fits_table(size_t size)
+	{
+		for (size_t i = 0; i < count; i++) {
+			for (size_t j = i + 1; j < count; j++) {
+				if ((hashes[i] & (size - 1)) == (hashes[j] & (size - 1)))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	static consteval size_t find_table_size()
+	{
+		for (auto size = std::bit_ceil(count); size <= MAX_TABLE_SIZE; size *= 2) {
+			if (fits_table(size))
+				return size;
+		}
+
+		return 0;
+	}
+
+	static constexpr size_t table_size = find_table_size();
+	static_assert(table_size != 0, "Duplicate or colliding keys");
+
+	// Index of the key + 1 for each slot, 0 if empty
+	static constexpr auto slots = [] {
+		std::array<unsigned char, table_size> result = {};
+
+		for (size_t i = 0; i < count; i++)
+			result[hashes[i] & (table_size - 1)] = (unsigned char)(i + 1);
+
+		return result;
+	}();
+
+	T values[count];
+
+public:
+	// Values in the same order as the keys
+	constexpr static_map(const T (&values)[count])
+	{
+		for (size_t i = 0; i < count; i++)
+			this->values[i] = values[i];
+	}
+
+	static constexpr size_t size()
+	{
+		return count;
+	}
+
+	// Only compares hashes, for callers that were handed a hash without its string
+	const T *find(hash_t key_hash) const
+	{
+		const auto slot = slots[key_hash & (table_size - 1)];
+		return slot != 0 && hashes[slot - 1] == key_hash ? &values[slot - 1] : nullptr;
+	}
+
+	const T *find(const char *str, size_t length) const
+	{
+		const auto *value = find(hash(str, length));
+		if (value == nullptr || names[value - values] != std::string_view(str, length))
+			return nullptr;
+
+		return value;
+	}
+
+	const T *find(const char *str) const
+	{
+		return find(str, std::char_traits<char>::length(str));
+	}
+};
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <gctypes.h>
+
+// Fixed-size histogram with evenly sized buckets. Values past the last bucket are counted in it.
+template<size_t N>
+class histogram {
+	u32 buckets[N];
+	u32 bucket_size;
+	u32 samples;
+	u32 max_value;
+	u64 total;
+
+public:
+	constexpr histogram(u32 bucket_size) : bucket_size(bucket_size)
+	{
+		clear();
+	}
+
+	constexpr void clear()
+	{
+		std::fill(buckets, buckets + N, 0u);
+		samples = 0;
+		max_value = 0;
+		total = 0;
+	}
+
+	void add(u32 value)
+	{
+		buckets[std::min(value / bucket_size, (u32)N - 1)]++;
+		samples++;
+		max_value = std::max(max_value, value);
+		total += value;
+	}
+
+	size_t size() const
+	{
+		return N;
+	}
+
+	u32 get_bucket_size() const
+	{
+		return bucket_size;
+	}
+
+	u32 get(size_t bucket) const
+	{
+		return buckets[bucket];
+	}
+
+	u32 count() const
+	{
+		return samples;
+	}
+
+	u32 max() const
+	{
+		return max_value;
+	}
+
+	u32 mean() const
+	{
+		return samples != 0 ? (u32)(total / samples) : 0;
+	}
+
+	// Upper bound of the bucket containing the given percentile
+	u32 percentile(u32 percent) const
+	{
+		const auto target = ((u64)samples * percent + 99) / 100;
+		u64 seen = 0;
+
+		for (size_t i = 0; i < N; i++) {
+			seen += buckets[i];
+			if (seen >= target && seen != 0)
+				return (u32)(i + 1) * bucket_size;
+		}
+
+		return max_value;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifdef HOOK_PROFILE
+
+#include "dolphin/vi.h"
+#include "console/console.h"
+#include "util/hash.h"
+#include "util/hooks.h"
+#include "util/time.h"
+#include <algorithm>
+#include <cstring>
+
+// Frame the counters were last reset on
+static u32 reset_retrace_count;
+
+static u32 ticks_to_ns(u64 ticks)
+{
+	return (u32)(ticks * 1000000000 / TIMEBASE_FREQUENCY);
+}
+
+static void print_hook_stats()
+{
+	const auto frames = std::max(1u, VIGetRetraceCount() - reset_retrace_count);
+
+	console::printf("%-28s %8s %9s %9s %9s", "hook", "calls", "incl ns", "self ns", "self us/f");
+
+	for (const auto *stats = __hook_stats_start; stats < __hook_stats_end; stats++) {
+		if (stats->calls == 0)
+			continue;
+
+		// Time the mod adds on top of the original function
+		const auto self_ticks = stats->ticks - stats->original_ticks;
+
+		console::printf("%-28s %8u %9u %9u %9u", stats->name, stats->calls,
+		                ticks_to_ns(stats->ticks / stats->calls),
+		                ticks_to_ns(self_ticks / stats->calls),
+		                ticks_to_us(self_ticks / frames));
+	}
+}
+
+static void reset_hook_stats()
+{
+	for (auto *stats = __hook_stats_start; stats < __hook_stats_end; stats++) {
+		stats->calls = 0;
+		stats->ticks = 0;
+		stats->original_ticks = 0;
+	}
+
+	reset_retrace_count = VIGetRetraceCount();
+}
+
+EVENT_HANDLER(events::console::cmd, [](unsigned int cmd_hash, int argc, const char *argv[])
+{
+	if (cmd_hash != hash<"hookstats">())
+		return false;
+
+	if (argc >= 2 && strcmp(argv[1], "reset") == 0)
+		reset_hook_stats();
+	else
+		print_hook_stats();
+
+	return true;
+});
+
+#endif
\ No newline at end of file
@@ -3,29 +3,165 @@
 #include "util/preprocessor.h"
 #include <type_traits>
 
+#ifdef HOOK_PROFILE
+#include "util/time.h"
+#include <gctypes.h>
+#endif
+
 template<typename T>
 struct hook_entry {
 	T orig;
 	T hook;
 };
 
+#ifdef HOOK_PROFILE
+
+// Per-hook counters, collected between __hook_stats_start and __hook_stats_end
+struct hook_stats {
+	const char *name;
+	u32 calls;
+	// Time base ticks spent in the hook, including the original function
+	u64 ticks;
+	// Time base ticks spent in the original function
+	u64 original_ticks;
+};
+
+extern hook_stats __hook_stats_start[];
+extern hook_stats __hook_stats_end[];
+
+class hook_timer {
+	u64 *ticks;
+	u32 start;
+
+public:
+	hook_timer(u64 *ticks) : ticks(ticks), start(get_ticks())
+	{
+	}
+
+	~hook_timer()
+	{
+		*ticks += get_ticks() - start;
+	}
+};
+
+#define HOOK_STATS(_name)                                                                          \
+	[[gnu::section(".hook_stats")]] [[gnu::used]]                                              \
+	static hook_stats stats = { .name = (_name) }
+
+#define HOOK_TIME_CALL()                                                                           \
+	stats.calls++;                                                                             \
+	const auto call_timer = hook_timer(&stats.ticks)
+
+#define HOOK_TIME_ORIGINAL(_original)                                                              \
+	[](auto ...original_va) {                                                                  \
+		const auto original_timer = hook_timer(&stats.original_ticks);                     \
+		return (_original)(original_va...);                                                \
+	}
+
+#else
+
+#define HOOK_STATS(_name) static_assert(true)
+#define HOOK_TIME_CALL() static_assert(true)
+#define HOOK_TIME_ORIGINAL(_original) (_original)
+
+#endif
+
 #define HOOK(_function, ...)                                                                       \
 	namespace CONCAT(_hook_, __COUNTER__) {                                                    \
 	static constexpr auto function = (_function);                                              \
+	HOOK_STATS(#_function);                                                                    \
 	[[gnu::section(".hooks")]] [[gnu::used]]                                                   \
 	static hook_entry<decltype(function)> entry = {                                            \
 		function,                                                                          \
 		[]<typename ret, typename ...args>(ret(*)(args...)) {                              \
 			return [](args ...va) -> ret {                                             \
-				const auto original = (ret(*)(args...))&entry;                     \
+				const auto original =                                              \
+					HOOK_TIME_ORIGINAL((ret(*)(args...))&entry);               \
 				const auto lambda = (__VA_ARGS__);                                 \
 				static_assert(requires { lambda(va...); },                         \
 					"Wrong hook parameter types");                             \
 				static_assert(std::is_same_v<decltype(lambda(va...)), ret>,        \
 					"Wrong hook return type");                                 \
+				HOOK_TIME_CALL();                                                  \
 				return lambda(va...);                                              \
 			};                                                                         \
 		}(function)                                                                        \
 	};                                                                                         \
 	}                                                                                          \
 	static_assert(true) // Force semicolon
+
+// Hooks for one function called in priority order (lowest first) from a single hook entry.
+// Each link's original() calls the next link, and the last one calls the original function.
+template<auto function>
+struct hook_chain;
+
+template<typename ret, typename ...args, ret(*function)(args...)>
+struct hook_chain<function> {
+	struct link {
+		ret(*hook)(args...);
+		int priority;
+		link *next;
+
+		link(ret(*hook)(args...), int priority) : hook(hook), priority(priority)
+		{
+			auto **insert = &head;
+
+			while (*insert != nullptr && (*insert)->priority <= priority)
+				insert = &(*insert)->next;
+
+			next = *insert;
+			*insert = this;
+		}
+	};
+
+	inline static link *head;
+	inline static ret(*original)(args...);
+
+	static ret call_next(const link *current, args ...va)
+	{
+		const auto *next = current != nullptr ? current->next : head;
+		return next != nullptr ? next->hook(va...) : original(va...);
+	}
+
+	static ret dispatch(args ...va)
+	{
+		return call_next(nullptr, va...);
+	}
+};
+
+// Install the hook entry for a chain. Use exactly once per function and don't combine with HOOK.
+#define HOOK_CHAIN_ENTRY(_function)                                                                \
+	namespace CONCAT(_hook_, __COUNTER__) {                                                    \
+	static constexpr auto function = (_function);                                              \
+	using chain = hook_chain<function>;                                                        \
+	[[gnu::section(".hooks")]] [[gnu::used]]                                                   \
+	static hook_entry<decltype(function)> entry = { function, chain::dispatch };               \
+	[[maybe_unused]] static const auto init =                                                  \
+		(chain::original = (decltype(chain::original))&entry, 0);                          \
+	}                                                                                          \
+	static_assert(true) // Force semicolon
+
+#define HOOK_CHAIN(_function, _priority, ...)                                                      \
+	namespace CONCAT(_hook_, __COUNTER__) {                                                    \
+	using chain = hook_chain<(_function)>;                                                     \
+	HOOK_STATS(#_function "[" #_priority "]");                                                 \
+	static chain::link link = {                                                                \
+		[]<typename ret, typename ...args>(ret(*)(args...)) {                              \
+			return [](args ...va) -> ret {                                             \
+				const auto original = HOOK_TIME_ORIGINAL(                          \
+					[](args ...next_va) -> ret {                               \
+						return chain::call_next(&link, next_va...);        \
+					});                                                        \
+				const auto lambda = (__VA_ARGS__);                                 \
+				static_assert(requires { lambda(va...); },                         \
+					"Wrong hook parameter types");                             \
+				static_assert(std::is_same_v<decltype(lambda(va...)), ret>,        \
+					"Wrong hook return type");                                 \
+				HOOK_TIME_CALL();                                                  \
+				return lambda(va...);                                              \
+			};                                                                         \
+		}(_function),                                                                      \
+		(_priority)                                                                        \
+	};                                                                                         \
+	}                                                                                          \
+	static_assert(true) // Force semicolon
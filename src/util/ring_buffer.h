@@ -1,13 +1,42 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <initializer_list>
+#include <span>
 
+// Fixed-size history indexed by the number of elements added before each. Sizes that are a power of
+// two wrap indices with a mask, others need a divide.
 template<typename T, size_t N>
 class ring_buffer {
 	T data[N];
 	size_t next_index = 0;
 
+	static constexpr size_t wrap(size_t index)
+	{
+		if constexpr (std::has_single_bit(N))
+			return index & (N - 1);
+		else
+			return index % N;
+	}
+
+	template<typename U>
+	static std::array<std::span<U>, 2> make_spans(U *data, size_t start, size_t end)
+	{
+		if (start == end)
+			return {};
+
+		const auto first = wrap(start);
+		const auto count = end - start;
+		const auto first_count = std::min(count, N - first);
+
+		return {
+			std::span<U>(&data[first], first_count),
+			std::span<U>(&data[0], count - first_count)
+		};
+	}
+
 public:
 	ring_buffer() = default;
 
@@ -45,12 +74,23 @@ public:
 
 	T *get(size_t index)
 	{
-		return is_valid_index(index) ? &data[index % N] : nullptr;
+		return is_valid_index(index) ? &data[wrap(index)] : nullptr;
 	}
 
 	const T *get(size_t index) const
 	{
-		return is_valid_index(index) ? &data[index % N] : nullptr;
+		return is_valid_index(index) ? &data[wrap(index)] : nullptr;
+	}
+
+	// Unchecked, the index must be between tail_index() and head_index()
+	T &operator[](size_t index)
+	{
+		return data[wrap(index)];
+	}
+
+	const T &operator[](size_t index) const
+	{
+		return data[wrap(index)];
 	}
 
 	bool set(size_t index, const T &value)
@@ -58,13 +98,25 @@ public:
 		if (!is_valid_index(index))
 			return false;
 
-		data[index % N] = value;
+		data[wrap(index)] = value;
 		return true;
 	}
 
 	void add(const T &value)
 	{
-		data[next_index++ % N] = value;
+		data[wrap(next_index++)] = value;
+	}
+
+	// Stored elements from start_index (or the oldest still stored) to the newest, oldest first,
+	// as up to two contiguous segments
+	std::array<std::span<T>, 2> spans(size_t start_index = 0)
+	{
+		return make_spans(data, std::clamp(start_index, tail_index(), next_index), next_index);
+	}
+
+	std::array<std::span<const T>, 2> spans(size_t start_index = 0) const
+	{
+		return make_spans(data, std::clamp(start_index, tail_index(), next_index), next_index);
 	}
 
 	size_t head_index(size_t offset = 0) const
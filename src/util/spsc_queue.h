@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+// Lock-free queue for one producer (e.g. an interrupt) and one consumer. N must be a power of 2.
+template<typename T, size_t N>
+class spsc_queue {
+	static_assert((N & (N - 1)) == 0, "Queue size must be a power of 2");
+
+	T data[N];
+	// Indices only ever increase, the queue is empty when they're equal
+	volatile size_t read_index = 0;
+	volatile size_t write_index = 0;
+
+public:
+	size_t capacity() const
+	{
+		return N;
+	}
+
+	size_t size() const
+	{
+		return write_index - read_index;
+	}
+
+	bool push(const T &value)
+	{
+		const auto write = write_index;
+		if (write - read_index >= N)
+			return false;
+
+		data[write & (N - 1)] = value;
+
+		// Publish the record only after it's written
+		asm volatile("" ::: "memory");
+		write_index = write + 1;
+		return true;
+	}
+
+	bool pop(T *value)
+	{
+		const auto read = read_index;
+		if (read == write_index)
+			return false;
+
+		asm volatile("" ::: "memory");
+		*value = data[read & (N - 1)];
+
+		asm volatile("" ::: "memory");
+		read_index = read + 1;
+		return true;
+	}
+};
\ No newline at end of file
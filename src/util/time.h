@@ -0,0 +1,61 @@
+#pragma once
+
+#include <gctypes.h>
+
+#ifndef GEKKO
+#include <chrono>
+#endif
+
+// Gekko time base runs at a quarter of the 162MHz bus clock
+constexpr u32 TIMEBASE_FREQUENCY = 162000000 / 4;
+
+#ifdef GEKKO
+
+// Read the lower half of the time base. Differences are valid across wraparound.
+inline u32 get_ticks()
+{
+	u32 ticks;
+	asm volatile("mftb %0" : "=r"(ticks));
+	return ticks;
+}
+
+// Read the full 64-bit time base
+inline u64 get_time()
+{
+	u32 upper, lower, check;
+
+	do {
+		asm volatile("mftbu %0" : "=r"(upper));
+		asm volatile("mftb %0"  : "=r"(lower));
+		asm volatile("mftbu %0" : "=r"(check));
+	} while (upper != check);
+
+	return ((u64)upper << 32) | lower;
+}
+
+#else
+
+// Host builds count the steady clock in time base ticks so conversions stay valid
+inline u64 get_time()
+{
+	const auto now = std::chrono::steady_clock::now().time_since_epoch();
+	const auto ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+	return ns * (TIMEBASE_FREQUENCY / 500000) / 2000;
+}
+
+inline u32 get_ticks()
+{
+	return (u32)get_time();
+}
+
+#endif
+
+constexpr u32 ticks_to_us(u64 ticks)
+{
+	return (u32)(ticks * 1000000 / TIMEBASE_FREQUENCY);
+}
+
+constexpr u32 us_to_ticks(u64 us)
+{
+	return (u32)(us * TIMEBASE_FREQUENCY / 1000000);
+}
\ No newline at end of file